@@ -0,0 +1,1175 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "AutosaveJournal.h"
+
+#include "FileWriterThread.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QLockFile>
+#include <QUuid>
+#include <QStandardPaths>
+#include <QtEndian>
+
+#include <openblox.h>
+#include <OBSerializer.h>
+#include <OBException.h>
+
+#include <instance/DataModel.h>
+
+#include <algorithm>
+#include <unordered_set>
+#include <climits>
+
+#define OB_STUDIO_JOURNAL_MAGIC 0x324A424F // OBJ2
+
+namespace OB{
+	namespace Studio{
+		// Every journal shares one writer, so their jobs stay in order
+		static FileWriterThread* ob_studio_autosave_writer = NULL;
+
+		static void ob_studio_autosave_post(std::function<void()> job){
+			if(!ob_studio_autosave_writer){
+				ob_studio_autosave_writer = new FileWriterThread();
+				ob_studio_autosave_writer->start(QThread::LowPriority);
+			}
+			ob_studio_autosave_writer->post(job);
+		}
+
+		typedef std::unordered_map<quint32, shared_ptr<Instance::Instance>> JournalIds;
+
+		static QByteArray ob_studio_id_key(quint32 id){
+			QByteArray key(4, 0);
+			qToLittleEndian<quint32>(id, (uchar*)key.data());
+			return key;
+		}
+
+		static bool ob_studio_key_id(const QByteArray& key, quint32* id){
+			if(key.size() != 4){
+				return false;
+			}
+			*id = qFromLittleEndian<quint32>((const uchar*)key.constData());
+			return true;
+		}
+
+		// Whether a snapshot would have inst in it
+		static bool ob_studio_journaled(shared_ptr<Instance::Instance> inst, shared_ptr<Instance::Instance> dm){
+			for(shared_ptr<Instance::Instance> cur = inst; cur; cur = cur->getParent()){
+				if(cur == dm){
+					return true;
+				}
+				if(!cur->getArchivable()){
+					return false;
+				}
+			}
+			return false;
+		}
+
+		static std::vector<shared_ptr<Instance::Instance>> ob_studio_journaled_kids(shared_ptr<Instance::Instance> parent){
+			std::vector<shared_ptr<Instance::Instance>> kids = parent->GetChildren();
+			kids.erase(std::remove_if(kids.begin(), kids.end(), [](const shared_ptr<Instance::Instance>& kid){
+				return !kid || !kid->getArchivable();
+			}), kids.end());
+			return kids;
+		}
+
+		static quint32 ob_studio_kid_index(shared_ptr<Instance::Instance> parent, shared_ptr<Instance::Instance> kid){
+			std::vector<shared_ptr<Instance::Instance>> kids = ob_studio_journaled_kids(parent);
+			return std::find(kids.begin(), kids.end(), kid) - kids.begin();
+		}
+
+		// Instances are always added last, so the ones that belong
+		// after kid are moved back behind it
+		static void ob_studio_place_at(shared_ptr<Instance::Instance> parent, shared_ptr<Instance::Instance> kid, quint32 index){
+			std::vector<shared_ptr<Instance::Instance>> kids = ob_studio_journaled_kids(parent);
+			for(size_t i = index; i < kids.size(); i++){
+				if(kids[i] == kid || kids[i]->ParentLocked){
+					continue;
+				}
+				kids[i]->setParent(NULL, false);
+				kids[i]->setParent(parent, false);
+			}
+		}
+
+		static void ob_studio_setup_journal_stream(QDataStream& stream){
+			stream.setByteOrder(QDataStream::LittleEndian);
+		}
+
+		static int ob_studio_file_generation(QString fileName, QString prefix){
+			if(!fileName.startsWith(prefix)){
+				return -1;
+			}
+
+			QString num = fileName.mid(prefix.length());
+			int dot = num.indexOf('.');
+			if(dot >= 0){
+				num = num.left(dot);
+			}
+
+			bool isInt;
+			int gen = num.toInt(&isInt);
+			return isInt ? gen : -1;
+		}
+
+		static int ob_studio_any_generation(QString fileName){
+			int gen = ob_studio_file_generation(fileName, "snapshot-");
+			gen = qMax(gen, ob_studio_file_generation(fileName, "journal-"));
+			return qMax(gen, ob_studio_file_generation(fileName, "ids-"));
+		}
+
+		static void ob_studio_remove_before(QString dir, int gen){
+			QDir d(dir);
+			QStringList files = d.entryList(QDir::Files);
+			for(int i = 0; i < files.size(); i++){
+				int fileGen = ob_studio_any_generation(files[i]);
+				if(fileGen >= 0 && fileGen < gen){
+					d.remove(files[i]);
+				}
+			}
+		}
+
+		// Ids of a snapshot's instances, by referent. Without an ids
+		// file they're the referents themselves.
+		static bool ob_studio_snapshot_ids(QString idsPath, const std::vector<shared_ptr<Instance::Instance>>& loaded, JournalIds* ids, QString* error){
+			QFile f(idsPath);
+			if(!f.open(QIODevice::ReadOnly)){
+				for(size_t i = 0; i < loaded.size(); i++){
+					if(loaded[i]){
+						(*ids)[i] = loaded[i];
+					}
+				}
+				return true;
+			}
+
+			QDataStream in(&f);
+			ob_studio_setup_journal_stream(in);
+
+			quint32 count;
+			in >> count;
+			if(in.status() != QDataStream::Ok || count != loaded.size()){
+				*error = "Autosave snapshot doesn't match its ids.";
+				return false;
+			}
+
+			for(quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++){
+				quint32 id;
+				in >> id;
+				if(id != OB_STUDIO_REF_NONE && loaded[i]){
+					(*ids)[id] = loaded[i];
+				}
+			}
+
+			if(in.status() != QDataStream::Ok){
+				*error = "Autosave snapshot doesn't match its ids.";
+				return false;
+			}
+			return true;
+		}
+
+		// Loads the newest snapshot before untilGen, or the file the
+		// journal started from if there isn't one
+		static bool ob_studio_load_start(OBEngine* eng, QDir d, int untilGen, int* startGen, JournalIds* ids, QString* error){
+			int snapGen = -1;
+			QStringList files = d.entryList(QDir::Files);
+			for(int i = 0; i < files.size(); i++){
+				int gen = ob_studio_file_generation(files[i], "snapshot-");
+				if(gen < untilGen){
+					snapGen = qMax(snapGen, gen);
+				}
+			}
+
+			bool fromSnapshot = snapGen >= 0;
+			QString startFile;
+			if(fromSnapshot){
+				startFile = d.filePath("snapshot-" + QString::number(snapGen) + "." OB_STUDIO_BINARY_PLACE_SUFFIX);
+			}else{
+				QFile base(d.filePath("base"));
+				if(base.open(QIODevice::ReadOnly)){
+					startFile = QString::fromUtf8(base.readAll());
+				}
+				snapGen = 0;
+			}
+			*startGen = snapGen;
+
+			std::vector<shared_ptr<Instance::Instance>> loaded;
+			if(!startFile.isEmpty()){
+				QFile f(startFile);
+				if(!f.open(QIODevice::ReadOnly)){
+					*error = "Failed to open the file this game was recovered from.";
+					return false;
+				}
+
+				QByteArray buf = f.readAll();
+				if(BinaryPlace::isBinary(buf.constData(), buf.size())){
+					if(!BinaryPlace::loadInto(eng, eng->getDataModel(), buf.constData(), buf.size(), error, NULL, &loaded)){
+						return false;
+					}
+				}else{
+					shared_ptr<OBSerializer> serializer = eng->getSerializer();
+					if(!serializer){
+						*error = "No serialization support.";
+						return false;
+					}
+					serializer->LoadFromMemory(buf.data(), buf.size());
+				}
+			}
+
+			if(fromSnapshot){
+				return ob_studio_snapshot_ids(d.filePath("ids-" + QString::number(snapGen)), loaded, ids, error);
+			}
+
+			// The tab walked the same file when it started the journal
+			std::vector<BinaryPlace::SavedInstance> walked;
+			BinaryPlace::walkGame(eng, &walked);
+			for(size_t i = 0; i < walked.size(); i++){
+				(*ids)[i] = walked[i].inst;
+			}
+			return true;
+		}
+
+		struct JournalMove{
+			quint32 id;
+			quint32 parent;
+			quint32 index;
+		};
+
+		struct JournalInsert{
+			quint32 parent;
+			quint32 index;
+			std::vector<quint32> ids;
+			QByteArray payload;
+		};
+
+		struct JournalRef{
+			shared_ptr<Instance::Instance> inst;
+			std::string prop;
+			quint32 id;
+		};
+
+		static bool ob_studio_apply_record(OBEngine* eng, QDataStream& rec, JournalIds& ids, QString* error){
+			std::vector<JournalMove> moves;
+			std::vector<JournalInsert> inserts;
+			std::vector<quint32> removes;
+			std::vector<std::pair<quint32, QByteArray>> props;
+
+			quint32 count;
+			rec >> count;
+			for(quint32 i = 0; i < count && rec.status() == QDataStream::Ok; i++){
+				JournalMove move;
+				rec >> move.id >> move.parent >> move.index;
+				moves.push_back(move);
+			}
+
+			rec >> count;
+			for(quint32 i = 0; i < count && rec.status() == QDataStream::Ok; i++){
+				JournalInsert insert;
+				quint32 idCount;
+				rec >> insert.parent >> insert.index >> idCount;
+				for(quint32 j = 0; j < idCount && rec.status() == QDataStream::Ok; j++){
+					quint32 id;
+					rec >> id;
+					insert.ids.push_back(id);
+				}
+				rec >> insert.payload;
+				inserts.push_back(insert);
+			}
+
+			rec >> count;
+			for(quint32 i = 0; i < count && rec.status() == QDataStream::Ok; i++){
+				quint32 id;
+				rec >> id;
+				removes.push_back(id);
+			}
+
+			rec >> count;
+			for(quint32 i = 0; i < count && rec.status() == QDataStream::Ok; i++){
+				quint32 id;
+				QByteArray payload;
+				rec >> id >> payload;
+				props.push_back(std::make_pair(id, payload));
+			}
+
+			if(rec.status() != QDataStream::Ok){
+				*error = "Autosave journal is corrupt.";
+				return false;
+			}
+
+			auto find = [&ids](quint32 id) -> shared_ptr<Instance::Instance> {
+				auto it = ids.find(id);
+				return it != ids.end() ? it->second : NULL;
+			};
+
+			// Everything leaves before anything arrives, so the indexes
+			// only count the children that stay
+			for(size_t i = 0; i < moves.size(); i++){
+				shared_ptr<Instance::Instance> inst = find(moves[i].id);
+				if(inst && !inst->ParentLocked){
+					inst->setParent(NULL, false);
+				}
+			}
+
+			// Instances that moved into a new subtree are written again
+			// with it, the old ones go too
+			std::vector<quint32> gone = removes;
+			for(size_t i = 0; i < inserts.size(); i++){
+				gone.insert(gone.end(), inserts[i].ids.begin(), inserts[i].ids.end());
+			}
+			for(size_t i = 0; i < gone.size(); i++){
+				shared_ptr<Instance::Instance> inst = find(gone[i]);
+				if(inst){
+					try{
+						inst->Destroy();
+					}catch(OBException* ex){}
+				}
+				ids.erase(gone[i]);
+			}
+
+			std::vector<JournalRef> refs;
+			BinaryPlace::RefBinder binder = [&refs](shared_ptr<Instance::Instance> inst, const std::string& prop, const QByteArray& key){
+				JournalRef ref;
+				if(ob_studio_key_id(key, &ref.id)){
+					ref.inst = inst;
+					ref.prop = prop;
+					refs.push_back(ref);
+				}
+			};
+
+			// Arrivals in index order, each one goes in behind the last
+			std::vector<std::pair<quint32, size_t>> arrivals;
+			for(size_t i = 0; i < moves.size(); i++){
+				arrivals.push_back(std::make_pair(moves[i].index, i));
+			}
+			for(size_t i = 0; i < inserts.size(); i++){
+				arrivals.push_back(std::make_pair(inserts[i].index, moves.size() + i));
+			}
+			std::stable_sort(arrivals.begin(), arrivals.end(), [](const std::pair<quint32, size_t>& a, const std::pair<quint32, size_t>& b){
+				return a.first < b.first;
+			});
+
+			for(size_t a = 0; a < arrivals.size(); a++){
+				size_t which = arrivals[a].second;
+
+				if(which < moves.size()){
+					const JournalMove& move = moves[which];
+					shared_ptr<Instance::Instance> inst = find(move.id);
+					shared_ptr<Instance::Instance> parent = find(move.parent);
+					if(inst && parent && !inst->ParentLocked){
+						inst->setParent(parent, false);
+						ob_studio_place_at(parent, inst, move.index);
+					}
+					continue;
+				}
+
+				const JournalInsert& insert = inserts[which - moves.size()];
+				shared_ptr<Instance::Instance> parent = find(insert.parent);
+				if(!parent){
+					continue;
+				}
+
+				std::vector<shared_ptr<Instance::Instance>> roots;
+				std::vector<shared_ptr<Instance::Instance>> loaded;
+				if(!BinaryPlace::loadInto(eng, parent, insert.payload.constData(), insert.payload.size(), error, &roots, &loaded, binder)){
+					return false;
+				}
+
+				for(size_t i = 0; i < loaded.size() && i < insert.ids.size(); i++){
+					if(loaded[i]){
+						ids[insert.ids[i]] = loaded[i];
+					}
+				}
+				if(!roots.empty()){
+					ob_studio_place_at(parent, roots[0], insert.index);
+				}
+			}
+
+			for(size_t i = 0; i < props.size(); i++){
+				shared_ptr<Instance::Instance> inst = find(props[i].first);
+				if(inst && !BinaryPlace::loadProperties(inst, props[i].second.constData(), props[i].second.size(), binder, error)){
+					return false;
+				}
+			}
+
+			// Only now does everything referred to exist
+			for(size_t i = 0; i < refs.size(); i++){
+				try{
+					refs[i].inst->setProperty(refs[i].prop, make_shared<Type::VarWrapper>(find(refs[i].id)));
+				}catch(OBException* ex){}
+			}
+
+			return true;
+		}
+
+		static bool ob_studio_apply_journal(OBEngine* eng, QString path, JournalIds& ids, QString* error){
+			QFile f(path);
+			if(!f.open(QIODevice::ReadOnly)){
+				*error = "Failed to read autosave journal.";
+				return false;
+			}
+
+			QByteArray all = f.readAll();
+			QDataStream in(all);
+			ob_studio_setup_journal_stream(in);
+
+			while(!in.atEnd()){
+				quint32 magic, storedSize;
+				in >> magic >> storedSize;
+				if(in.status() != QDataStream::Ok || magic != OB_STUDIO_JOURNAL_MAGIC || in.device()->pos() + storedSize > all.size()){
+					// A record cut short by a crash, everything before it
+					// is still good
+					break;
+				}
+
+				QByteArray record = qUncompress(QByteArray::fromRawData(all.constData() + in.device()->pos(), storedSize));
+				in.skipRawData(storedSize);
+
+				QDataStream rec(record);
+				ob_studio_setup_journal_stream(rec);
+
+				// Same for one that doesn't make sense
+				QString recError;
+				if(!ob_studio_apply_record(eng, rec, ids, &recError)){
+					break;
+				}
+			}
+
+			return true;
+		}
+
+		// The start file and every journal after it, up to untilGen
+		static bool ob_studio_replay(OBEngine* eng, QString dir, int untilGen, JournalIds* ids, QString* error){
+			QDir d(dir);
+
+			int startGen;
+			if(!ob_studio_load_start(eng, d, untilGen, &startGen, ids, error)){
+				return false;
+			}
+
+			std::vector<int> journals;
+			QStringList files = d.entryList(QDir::Files);
+			for(int i = 0; i < files.size(); i++){
+				int jGen = ob_studio_file_generation(files[i], "journal-");
+				if(jGen >= startGen && jGen < untilGen){
+					journals.push_back(jGen);
+				}
+			}
+			std::sort(journals.begin(), journals.end());
+
+			for(size_t i = 0; i < journals.size(); i++){
+				if(!ob_studio_apply_journal(eng, d.filePath("journal-" + QString::number(journals[i])), *ids, error)){
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		// Runs on the writer thread. Snapshot gen is built by playing
+		// the journals before it into an engine of our own, so the
+		// tab's engine is never stopped for it. Nothing older is
+		// removed unless the new snapshot was written.
+		static void ob_studio_compact(QString dir, int gen){
+			OBEngine* eng = new OBEngine();
+			eng->setRendering(false);
+			eng->init();
+
+			JournalIds ids;
+			QString error;
+			QByteArray data;
+			std::vector<BinaryPlace::SavedInstance> saved;
+			bool built = ob_studio_replay(eng, dir, gen, &ids, &error) && BinaryPlace::save(eng, true, &data, &error, &saved);
+
+			if(built){
+				std::unordered_map<Instance::Instance*, quint32> idOf;
+				for(auto it = ids.begin(); it != ids.end(); ++it){
+					idOf[it->second.get()] = it->first;
+				}
+
+				QByteArray idList;
+				QDataStream out(&idList, QIODevice::WriteOnly);
+				ob_studio_setup_journal_stream(out);
+
+				out << (quint32)saved.size();
+				for(size_t i = 0; i < saved.size(); i++){
+					auto it = idOf.find(saved[i].inst.get());
+					out << (it != idOf.end() ? it->second : (quint32)OB_STUDIO_REF_NONE);
+				}
+
+				// The ids go first, a snapshot is only used once it's there
+				QDir d(dir);
+				QSaveFile idsFile(d.filePath("ids-" + QString::number(gen)));
+				QSaveFile snapFile(d.filePath("snapshot-" + QString::number(gen) + "." OB_STUDIO_BINARY_PLACE_SUFFIX));
+				built = idsFile.open(QIODevice::WriteOnly) && idsFile.write(idList) == idList.size() && idsFile.commit() &&
+					snapFile.open(QIODevice::WriteOnly) && snapFile.write(data) == data.size() && snapFile.commit();
+			}
+
+			// Instances have to go before their engine does
+			saved.clear();
+			ids.clear();
+			delete eng;
+
+			if(built){
+				ob_studio_remove_before(dir, gen);
+			}
+		}
+
+		AutosaveJournal::AutosaveJournal(QString dir){
+			generation = 0;
+			deltasSinceSnapshot = 0;
+			snapshotRunning = false;
+			needsSnapshot = false;
+			hasBaseline = false;
+			nextId = 0;
+			lockFile = NULL;
+
+			if(dir.isEmpty()){
+				this->dir = getAutosaveRoot() + "/" + QUuid::createUuid().toString().mid(1, 36);
+				dirCreated = false;
+			}else{
+				// Picking up where a recovered journal left off
+				this->dir = dir;
+				dirCreated = true;
+
+				lockFile = new QLockFile(this->dir + "/lock");
+				lockFile->tryLock(0);
+
+				QStringList files = QDir(this->dir).entryList(QDir::Files);
+				for(int i = 0; i < files.size(); i++){
+					generation = qMax(generation, ob_studio_any_generation(files[i]));
+				}
+
+				QFile base(this->dir + "/base");
+				if(base.open(QIODevice::ReadOnly)){
+					baseFile = QString::fromUtf8(base.readAll());
+				}
+
+				// Start the next snapshot from what we have now
+				needsSnapshot = true;
+			}
+		}
+
+		AutosaveJournal::~AutosaveJournal(){
+			delete lockFile;
+		}
+
+		QString AutosaveJournal::getDir(){
+			return dir;
+		}
+
+		QString AutosaveJournal::getBaseFile(){
+			return baseFile;
+		}
+
+		void AutosaveJournal::setBaseFile(QString baseFile){
+			this->baseFile = baseFile;
+
+			if(dirCreated){
+				QString basePath = dir + "/base";
+				ob_studio_autosave_post([basePath, baseFile](){
+					QFile f(basePath);
+					if(f.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+						f.write(baseFile.toUtf8());
+					}
+				});
+			}
+		}
+
+		void AutosaveJournal::setBaseline(OBEngine* eng){
+			std::vector<BinaryPlace::SavedInstance> walked;
+			BinaryPlace::walkGame(eng, &walked);
+			setBaseline(walked);
+		}
+
+		// Ids start out as positions in saved, which is how recovery
+		// numbers whatever it starts from
+		void AutosaveJournal::setBaseline(const std::vector<BinaryPlace::SavedInstance>& saved){
+			nodes.clear();
+			ids.clear();
+
+			for(size_t i = 0; i < saved.size(); i++){
+				Node& node = nodes[i];
+				node.inst = saved[i].inst;
+				node.parent = saved[i].parent;
+				if(node.parent != OB_STUDIO_REF_NONE){
+					nodes[node.parent].kids.push_back(i);
+				}
+				ids[saved[i].inst.get()] = i;
+			}
+
+			nextId = saved.size();
+			hasBaseline = true;
+		}
+
+		void AutosaveJournal::markChildrenChanged(shared_ptr<Instance::Instance> parent){
+			if(parent){
+				dirtyParents[parent.get()] = parent;
+			}
+		}
+
+		void AutosaveJournal::markPropertyChanged(shared_ptr<Instance::Instance> inst, std::string prop){
+			if(!inst || prop == "Parent"){
+				// Moves are seen as children changing
+				return;
+			}
+
+			if(prop == "Archivable"){
+				// Comes or goes from what's saved, like a move
+				markChildrenChanged(inst->getParent());
+				return;
+			}
+
+			PropChange& change = dirtyProps[inst.get()];
+			if(change.inst.lock() != inst){
+				change.inst = inst;
+				change.props.clear();
+			}
+			if(std::find(change.props.begin(), change.props.end(), prop) == change.props.end()){
+				change.props.push_back(prop);
+			}
+		}
+
+		bool AutosaveJournal::hasPendingChanges(){
+			return needsSnapshot || !dirtyParents.empty() || !dirtyProps.empty();
+		}
+
+		bool AutosaveJournal::idFor(shared_ptr<Instance::Instance> inst, quint32* id){
+			if(!inst){
+				return false;
+			}
+
+			auto it = ids.find(inst.get());
+			if(it == ids.end()){
+				return false;
+			}
+
+			auto nIt = nodes.find(it->second);
+			if(nIt == nodes.end() || nIt->second.inst.lock() != inst){
+				// Same address, different instance
+				ids.erase(it);
+				return false;
+			}
+
+			*id = it->second;
+			return true;
+		}
+
+		quint32 AutosaveJournal::addId(shared_ptr<Instance::Instance> inst){
+			quint32 id = nextId++;
+
+			Node& node = nodes[id];
+			node.inst = inst;
+			node.parent = OB_STUDIO_REF_NONE;
+			ids[inst.get()] = id;
+
+			return id;
+		}
+
+		// Drops id and whatever is still under it. Anything that moved
+		// out already has its new parent.
+		void AutosaveJournal::forget(quint32 id){
+			std::vector<quint32> toForget(1, id);
+			while(!toForget.empty()){
+				quint32 cur = toForget.back();
+				toForget.pop_back();
+
+				auto it = nodes.find(cur);
+				if(it == nodes.end()){
+					continue;
+				}
+
+				shared_ptr<Instance::Instance> inst = it->second.inst.lock();
+				if(inst){
+					auto iIt = ids.find(inst.get());
+					if(iIt != ids.end() && iIt->second == cur){
+						ids.erase(iIt);
+					}
+				}
+
+				const std::vector<quint32>& kids = it->second.kids;
+				for(size_t i = 0; i < kids.size(); i++){
+					auto kIt = nodes.find(kids[i]);
+					if(kIt != nodes.end() && kIt->second.parent == cur){
+						toForget.push_back(kids[i]);
+					}
+				}
+
+				nodes.erase(it);
+			}
+		}
+
+		bool AutosaveJournal::writeDelta(OBEngine* eng){
+			shared_ptr<Instance::DataModel> dm = eng->getDataModel();
+			if(!dm || !hasBaseline){
+				return false;
+			}
+
+			std::unordered_map<Instance::Instance*, std::weak_ptr<Instance::Instance>> parentsToWrite;
+			parentsToWrite.swap(dirtyParents);
+
+			std::unordered_map<Instance::Instance*, PropChange> propsToWrite;
+			propsToWrite.swap(dirtyProps);
+
+			// Anything that came or went was a child of one of these,
+			// before or after
+			std::vector<shared_ptr<Instance::Instance>> parents;
+			std::vector<shared_ptr<Instance::Instance>> touched;
+			std::unordered_set<Instance::Instance*> seen;
+			std::vector<quint32> removes;
+
+			for(auto it = parentsToWrite.begin(); it != parentsToWrite.end(); ++it){
+				shared_ptr<Instance::Instance> parent = it->second.lock();
+				if(!parent){
+					continue;
+				}
+				if(parent == dm){
+					// Services came or went, that needs a snapshot
+					needsSnapshot = true;
+					continue;
+				}
+
+				quint32 pid;
+				if(!idFor(parent, &pid)){
+					// New, it's written whole along with its children
+					continue;
+				}
+				parents.push_back(parent);
+
+				const std::vector<quint32>& was = nodes[pid].kids;
+				for(size_t i = 0; i < was.size(); i++){
+					auto kIt = nodes.find(was[i]);
+					shared_ptr<Instance::Instance> kid = kIt != nodes.end() ? kIt->second.inst.lock() : NULL;
+					if(!kid){
+						removes.push_back(was[i]);
+					}else if(seen.insert(kid.get()).second){
+						touched.push_back(kid);
+					}
+				}
+
+				std::vector<shared_ptr<Instance::Instance>> kids = ob_studio_journaled_kids(parent);
+				for(size_t i = 0; i < kids.size(); i++){
+					if(seen.insert(kids[i].get()).second){
+						touched.push_back(kids[i]);
+					}
+				}
+			}
+
+			std::vector<shared_ptr<Instance::Instance>> moved;
+			std::vector<shared_ptr<Instance::Instance>> added;
+			std::unordered_set<Instance::Instance*> movedSet;
+			std::unordered_set<Instance::Instance*> addedSet;
+
+			for(size_t i = 0; i < touched.size(); i++){
+				shared_ptr<Instance::Instance> kid = touched[i];
+				quint32 id;
+
+				if(!ob_studio_journaled(kid, dm)){
+					if(idFor(kid, &id)){
+						removes.push_back(id);
+					}
+					continue;
+				}
+
+				// Anything under a new instance is written along with it
+				shared_ptr<Instance::Instance> top;
+				for(shared_ptr<Instance::Instance> cur = kid; cur && cur != dm; cur = cur->getParent()){
+					if(!idFor(cur, &id)){
+						top = cur;
+					}
+				}
+				if(top){
+					if(top->getParent() != dm && addedSet.insert(top.get()).second){
+						added.push_back(top);
+					}
+					continue;
+				}
+
+				quint32 pid;
+				idFor(kid, &id);
+				if(idFor(kid->getParent(), &pid) && nodes[id].parent != pid){
+					moved.push_back(kid);
+					movedSet.insert(kid.get());
+				}
+			}
+
+			// Children that stayed but changed order move from the
+			// first one that's out of place
+			for(size_t i = 0; i < parents.size(); i++){
+				quint32 pid;
+				if(!ob_studio_journaled(parents[i], dm) || !idFor(parents[i], &pid)){
+					continue;
+				}
+
+				std::vector<quint32> stayedWas;
+				const std::vector<quint32>& was = nodes[pid].kids;
+				std::unordered_set<quint32> wasSet(was.begin(), was.end());
+				for(size_t k = 0; k < was.size(); k++){
+					auto kIt = nodes.find(was[k]);
+					shared_ptr<Instance::Instance> kid = kIt != nodes.end() ? kIt->second.inst.lock() : NULL;
+					if(kid && kid->getParent() == parents[i] && !movedSet.count(kid.get()) && ob_studio_journaled(kid, dm)){
+						stayedWas.push_back(was[k]);
+					}
+				}
+
+				std::vector<shared_ptr<Instance::Instance>> stayedNow;
+				std::vector<shared_ptr<Instance::Instance>> kids = ob_studio_journaled_kids(parents[i]);
+				for(size_t k = 0; k < kids.size(); k++){
+					quint32 kid;
+					if(idFor(kids[k], &kid) && !movedSet.count(kids[k].get()) && wasSet.count(kid)){
+						stayedNow.push_back(kids[k]);
+					}
+				}
+
+				size_t same = 0;
+				while(same < stayedNow.size() && same < stayedWas.size()){
+					quint32 kid;
+					idFor(stayedNow[same], &kid);
+					if(kid != stayedWas[same]){
+						break;
+					}
+					same++;
+				}
+				for(size_t k = same; k < stayedNow.size(); k++){
+					moved.push_back(stayedNow[k]);
+					movedSet.insert(stayedNow[k].get());
+				}
+			}
+
+			// New instances get their ids before anything is written,
+			// so Instance values can refer to them from anywhere
+			std::vector<std::vector<BinaryPlace::SavedInstance>> addedWalks(added.size());
+			std::vector<std::vector<quint32>> addedIds(added.size());
+			std::unordered_set<Instance::Instance*> rewritten;
+			for(size_t a = 0; a < added.size(); a++){
+				BinaryPlace::walk(std::vector<shared_ptr<Instance::Instance>>(1, added[a]), &addedWalks[a]);
+
+				for(size_t i = 0; i < addedWalks[a].size(); i++){
+					shared_ptr<Instance::Instance> inst = addedWalks[a][i].inst;
+					quint32 id;
+					if(!idFor(inst, &id)){
+						id = addId(inst);
+					}
+					addedIds[a].push_back(id);
+					rewritten.insert(inst.get());
+				}
+			}
+
+			BinaryPlace::RefNamer namer = [this](shared_ptr<Instance::Instance> inst) -> QByteArray {
+				quint32 id;
+				return idFor(inst, &id) ? ob_studio_id_key(id) : QByteArray();
+			};
+
+			std::vector<std::pair<quint32, QByteArray>> propRecords;
+			for(auto it = propsToWrite.begin(); it != propsToWrite.end(); ++it){
+				shared_ptr<Instance::Instance> inst = it->second.inst.lock();
+				quint32 id;
+				if(!inst || rewritten.count(inst.get()) || !idFor(inst, &id) || !ob_studio_journaled(inst, dm)){
+					continue;
+				}
+
+				QByteArray payload;
+				BinaryPlace::saveProperties(inst, it->second.props, namer, &payload);
+				if(payload.size() > 4){
+					propRecords.push_back(std::make_pair(id, payload));
+				}
+			}
+
+			bool empty = moved.empty() && added.empty() && removes.empty() && propRecords.empty();
+
+			QByteArray record;
+			QDataStream out(&record, QIODevice::WriteOnly);
+			ob_studio_setup_journal_stream(out);
+
+			out << (quint32)moved.size();
+			for(size_t i = 0; i < moved.size(); i++){
+				shared_ptr<Instance::Instance> parent = moved[i]->getParent();
+				quint32 id, pid;
+				idFor(moved[i], &id);
+				idFor(parent, &pid);
+				out << id << pid << ob_studio_kid_index(parent, moved[i]);
+			}
+
+			out << (quint32)added.size();
+			for(size_t a = 0; a < added.size(); a++){
+				shared_ptr<Instance::Instance> parent = added[a]->getParent();
+				quint32 pid;
+				idFor(parent, &pid);
+
+				QByteArray payload;
+				QString error;
+				BinaryPlace::saveInstances(std::vector<shared_ptr<Instance::Instance>>(1, added[a]), false, &payload, &error, NULL, namer);
+
+				out << pid << ob_studio_kid_index(parent, added[a]) << (quint32)addedIds[a].size();
+				for(size_t i = 0; i < addedIds[a].size(); i++){
+					out << addedIds[a][i];
+				}
+				out << payload;
+			}
+
+			out << (quint32)removes.size();
+			for(size_t i = 0; i < removes.size(); i++){
+				out << removes[i];
+			}
+
+			out << (quint32)propRecords.size();
+			for(size_t i = 0; i < propRecords.size(); i++){
+				out << propRecords[i].first << propRecords[i].second;
+			}
+
+			// Bring the tree up to what was just written. Instances
+			// that moved keep their node, so by the time anything is
+			// forgotten they're no longer under it.
+			for(size_t a = 0; a < added.size(); a++){
+				for(size_t i = 0; i < addedWalks[a].size(); i++){
+					Node& node = nodes[addedIds[a][i]];
+					node.kids.clear();
+
+					quint32 parentRef = addedWalks[a][i].parent;
+					if(parentRef == OB_STUDIO_REF_NONE){
+						idFor(added[a]->getParent(), &node.parent);
+					}else{
+						node.parent = addedIds[a][parentRef];
+						nodes[node.parent].kids.push_back(addedIds[a][i]);
+					}
+				}
+			}
+
+			for(size_t i = 0; i < moved.size(); i++){
+				quint32 id, pid;
+				if(idFor(moved[i], &id) && idFor(moved[i]->getParent(), &pid)){
+					nodes[id].parent = pid;
+				}
+			}
+
+			for(size_t i = 0; i < parents.size(); i++){
+				quint32 pid;
+				if(!ob_studio_journaled(parents[i], dm) || !idFor(parents[i], &pid)){
+					continue;
+				}
+
+				std::vector<shared_ptr<Instance::Instance>> kids = ob_studio_journaled_kids(parents[i]);
+				std::vector<quint32> now;
+				now.reserve(kids.size());
+				for(size_t k = 0; k < kids.size(); k++){
+					quint32 kid;
+					if(idFor(kids[k], &kid)){
+						now.push_back(kid);
+					}
+				}
+				nodes[pid].kids.swap(now);
+			}
+
+			for(size_t i = 0; i < removes.size(); i++){
+				forget(removes[i]);
+			}
+
+			if(empty){
+				return false;
+			}
+
+			ensureDir();
+
+			// Compressing and writing is the writer's problem
+			QString path = journalPath(generation);
+			ob_studio_autosave_post([path, record](){
+				QByteArray stored = qCompress(record, 1);
+
+				QFile f(path);
+				if(f.open(QIODevice::WriteOnly | QIODevice::Append)){
+					QDataStream fOut(&f);
+					ob_studio_setup_journal_stream(fOut);
+					fOut << (quint32)OB_STUDIO_JOURNAL_MAGIC << (quint32)stored.size();
+					fOut.writeRawData(stored.constData(), stored.size());
+					f.flush();
+				}
+			});
+
+			if(++deltasSinceSnapshot >= OB_STUDIO_AUTOSAVE_SNAPSHOT_EVERY){
+				compact();
+			}
+			return true;
+		}
+
+		// Later records go to the next journal while the writer folds
+		// this one into a snapshot
+		void AutosaveJournal::compact(){
+			generation++;
+			deltasSinceSnapshot = 0;
+
+			QString dir = this->dir;
+			int gen = generation;
+			ob_studio_autosave_post([dir, gen](){
+				ob_studio_compact(dir, gen);
+			});
+		}
+
+		bool AutosaveJournal::isSnapshotDue(){
+			if(snapshotRunning){
+				return false;
+			}
+			if(needsSnapshot){
+				return true;
+			}
+			// Without anything to build on, records mean nothing
+			return !hasBaseline && hasPendingChanges();
+		}
+
+		QString AutosaveJournal::beginSnapshot(){
+			ensureDir();
+
+			snapshotRunning = true;
+			generation++;
+			deltasSinceSnapshot = 0;
+			needsSnapshot = false;
+
+			// The snapshot is taken after this, so it has everything
+			dirtyParents.clear();
+			dirtyProps.clear();
+
+			return snapshotPath(generation);
+		}
+
+		void AutosaveJournal::endSnapshot(bool succeeded, const std::vector<BinaryPlace::SavedInstance>& saved){
+			snapshotRunning = false;
+
+			if(!succeeded){
+				needsSnapshot = true;
+				return;
+			}
+
+			setBaseline(saved);
+
+			QString dir = this->dir;
+			int gen = generation;
+			ob_studio_autosave_post([dir, gen](){
+				ob_studio_remove_before(dir, gen);
+			});
+		}
+
+		void AutosaveJournal::reset(){
+			dirtyParents.clear();
+			dirtyProps.clear();
+			nodes.clear();
+			ids.clear();
+			hasBaseline = false;
+			nextId = 0;
+			generation = 0;
+			deltasSinceSnapshot = 0;
+			needsSnapshot = false;
+
+			if(dirCreated){
+				delete lockFile;
+				lockFile = NULL;
+
+				QString oldDir = dir;
+				ob_studio_autosave_post([oldDir](){
+					QDir(oldDir).removeRecursively();
+				});
+			}
+
+			// A fresh directory, the old one may still have jobs queued
+			dir = getAutosaveRoot() + "/" + QUuid::createUuid().toString().mid(1, 36);
+			dirCreated = false;
+		}
+
+		void AutosaveJournal::ensureDir(){
+			if(dirCreated){
+				return;
+			}
+
+			QDir().mkpath(dir);
+			dirCreated = true;
+
+			lockFile = new QLockFile(dir + "/lock");
+			lockFile->tryLock(0);
+
+			if(!baseFile.isEmpty()){
+				setBaseFile(baseFile);
+			}
+		}
+
+		QString AutosaveJournal::journalPath(int gen){
+			return dir + "/journal-" + QString::number(gen);
+		}
+
+		QString AutosaveJournal::snapshotPath(int gen){
+			return dir + "/snapshot-" + QString::number(gen) + "." OB_STUDIO_BINARY_PLACE_SUFFIX;
+		}
+
+		QString AutosaveJournal::getAutosaveRoot(){
+			return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/autosave";
+		}
+
+		QStringList AutosaveJournal::findRecoverable(){
+			QStringList found;
+
+			QDir root(getAutosaveRoot());
+			QStringList dirs = root.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+			for(int i = 0; i < dirs.size(); i++){
+				QString path = root.filePath(dirs[i]);
+				if(!isJournalDir(path)){
+					continue;
+				}
+
+				// Skip journals another running Studio is using
+				QLockFile lock(path + "/lock");
+				if(!lock.tryLock(0)){
+					continue;
+				}
+				lock.unlock();
+
+				found.append(path);
+			}
+
+			return found;
+		}
+
+		bool AutosaveJournal::isJournalDir(QString path){
+			QDir d(path);
+			if(!d.exists()){
+				return false;
+			}
+
+			QStringList files = d.entryList(QDir::Files);
+			for(int i = 0; i < files.size(); i++){
+				if(files[i].startsWith("snapshot-") || files[i].startsWith("journal-")){
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool AutosaveJournal::recover(OBEngine* eng, QString dir, QString* error){
+			JournalIds ids;
+			return ob_studio_replay(eng, dir, INT_MAX, &ids, error);
+		}
+
+		void AutosaveJournal::shutdown(){
+			if(ob_studio_autosave_writer){
+				ob_studio_autosave_writer->requestStop();
+				ob_studio_autosave_writer->wait();
+
+				delete ob_studio_autosave_writer;
+				ob_studio_autosave_writer = NULL;
+			}
+		}
+	}
+}
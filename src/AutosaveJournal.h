@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OB_STUDIO_AUTOSAVEJOURNAL_H_
+#define OB_STUDIO_AUTOSAVEJOURNAL_H_
+
+#include <QString>
+#include <QStringList>
+#include <QLockFile>
+
+#include "BinaryPlace.h"
+
+#include <OBEngine.h>
+#include <instance/Instance.h>
+
+#include <unordered_map>
+
+#define OB_STUDIO_DEFAULT_AUTOSAVE_INTERVAL 30
+#define OB_STUDIO_AUTOSAVE_SNAPSHOT_EVERY 20
+
+namespace OB{
+	namespace Studio{
+		/*
+		 * Crash recovery for one tab. Every instance the journal knows
+		 * of has an id that doesn't change when it's renamed or moved,
+		 * and the journal keeps the shape of the tree as of its last
+		 * write. Each autosave appends a record of what changed since:
+		 *
+		 *  moves    id, new parent's id and index among its children
+		 *  inserts  parent's id, index and the new subtree
+		 *  removes  ids that left the game
+		 *  props    id and just the properties that changed
+		 *
+		 * Instance values that point outside of what a record carries
+		 * are written as ids too. Only instances that changed are ever
+		 * serialized.
+		 *
+		 * Every so often the writer thread folds the journal into a
+		 * new snapshot by replaying it into an engine of its own, so
+		 * the tab's engine is left alone. The tab only snapshots
+		 * itself when there's nothing to build on: a new game, a
+		 * recovered one, or one whose services came or went.
+		 *
+		 * A journal lives in its own directory:
+		 *
+		 *  base               file the tab was opened from, if any
+		 *  snapshot-N.obgb    full binary snapshot
+		 *  ids-N              ids of snapshot N's instances, in
+		 *                     referent order, unless they're just
+		 *                     0, 1, 2...
+		 *  journal-N          records to apply on top of snapshot N,
+		 *                     or on top of base when N is 0
+		 *
+		 * Files are only ever written by a single writer thread, so
+		 * autosaving never waits on the disk.
+		 */
+		class AutosaveJournal{
+		public:
+			AutosaveJournal(QString dir = QString());
+			virtual ~AutosaveJournal();
+
+			QString getDir();
+			QString getBaseFile();
+			void setBaseFile(QString baseFile);
+
+			// What's in the game now, or what was just saved, is what
+			// the next record builds on. Caller must hold the engine.
+			void setBaseline(OBEngine* eng);
+			void setBaseline(const std::vector<BinaryPlace::SavedInstance>& saved);
+
+			void markChildrenChanged(shared_ptr<Instance::Instance> parent);
+			void markPropertyChanged(shared_ptr<Instance::Instance> inst, std::string prop);
+			bool hasPendingChanges();
+
+			// Caller must hold the engine
+			bool writeDelta(OBEngine* eng);
+
+			bool isSnapshotDue();
+			QString beginSnapshot();
+			void endSnapshot(bool succeeded, const std::vector<BinaryPlace::SavedInstance>& saved);
+
+			// Forget everything, the tab was saved or closed cleanly
+			void reset();
+
+			static QString getAutosaveRoot();
+			static QStringList findRecoverable();
+			static bool isJournalDir(QString path);
+
+			// Caller must hold the engine
+			static bool recover(OBEngine* eng, QString dir, QString* error);
+
+			static void shutdown();
+
+		private:
+			struct Node{
+				std::weak_ptr<Instance::Instance> inst;
+				quint32 parent;
+				std::vector<quint32> kids;
+			};
+
+			struct PropChange{
+				std::weak_ptr<Instance::Instance> inst;
+				std::vector<std::string> props;
+			};
+
+			bool idFor(shared_ptr<Instance::Instance> inst, quint32* id);
+			quint32 addId(shared_ptr<Instance::Instance> inst);
+			void forget(quint32 id);
+			void compact();
+
+			void ensureDir();
+			QString journalPath(int gen);
+			QString snapshotPath(int gen);
+
+			QString dir;
+			bool dirCreated;
+			QLockFile* lockFile;
+			QString baseFile;
+
+			int generation;
+			int deltasSinceSnapshot;
+			bool snapshotRunning;
+			bool needsSnapshot;
+
+			// The tree as of the last record
+			bool hasBaseline;
+			quint32 nextId;
+			std::unordered_map<quint32, Node> nodes;
+			std::unordered_map<Instance::Instance*, quint32> ids;
+
+			std::unordered_map<Instance::Instance*, std::weak_ptr<Instance::Instance>> dirtyParents;
+			std::unordered_map<Instance::Instance*, PropChange> dirtyProps;
+		};
+	}
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// End:
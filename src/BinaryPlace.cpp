@@ -0,0 +1,835 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "BinaryPlace.h"
+
+#include "PropertySchema.h"
+
+#include <QDataStream>
+
+#include <openblox.h>
+#include <OBException.h>
+
+#include <instance/Instance.h>
+#include <instance/DataModel.h>
+
+#include <type/Color3.h>
+#include <type/Vector3.h>
+#include <type/Vector2.h>
+#include <type/UDim.h>
+#include <type/UDim2.h>
+
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+
+#define OB_STUDIO_FOURCC(a, b, c, d) ((quint32)(a) | ((quint32)(b) << 8) | ((quint32)(c) << 16) | ((quint32)(d) << 24))
+
+#define OB_STUDIO_CHUNK_STRS OB_STUDIO_FOURCC('S', 'T', 'R', 'S')
+#define OB_STUDIO_CHUNK_INST OB_STUDIO_FOURCC('I', 'N', 'S', 'T')
+#define OB_STUDIO_CHUNK_EXTR OB_STUDIO_FOURCC('E', 'X', 'T', 'R')
+#define OB_STUDIO_CHUNK_PRNT OB_STUDIO_FOURCC('P', 'R', 'N', 'T')
+#define OB_STUDIO_CHUNK_END OB_STUDIO_FOURCC('E', 'N', 'D', '\0')
+
+#define OB_STUDIO_CHUNK_COMPRESSED 0x1
+
+// Not worth compressing below this
+#define OB_STUDIO_CHUNK_MIN_COMPRESS 256
+
+// Instance values with this bit set index the EXTR chunk instead
+#define OB_STUDIO_REF_EXTERNAL 0x80000000
+
+namespace OB{
+	namespace Studio{
+		static const char ob_studio_binary_magic[4] = {'O', 'B', 'G', 'B'};
+
+		typedef std::vector<std::pair<std::string, PropertyType>> ColumnList;
+
+		// Referents of everything being saved, and the keys of
+		// anything outside of it the namer could name
+		struct RefTable{
+			std::unordered_map<Instance::Instance*, quint32> refs;
+			BinaryPlace::RefNamer namer;
+			std::vector<QByteArray> externals;
+			std::unordered_map<Instance::Instance*, quint32> externalIdx;
+
+			quint32 refFor(shared_ptr<Instance::Instance> inst){
+				if(!inst){
+					return OB_STUDIO_REF_NONE;
+				}
+
+				auto it = refs.find(inst.get());
+				if(it != refs.end()){
+					return it->second;
+				}
+
+				if(!namer){
+					return OB_STUDIO_REF_NONE;
+				}
+
+				auto eIt = externalIdx.find(inst.get());
+				if(eIt != externalIdx.end()){
+					return OB_STUDIO_REF_EXTERNAL | eIt->second;
+				}
+
+				QByteArray key = namer(inst);
+				if(key.isEmpty()){
+					return OB_STUDIO_REF_NONE;
+				}
+
+				quint32 idx = externals.size();
+				externals.push_back(key);
+				externalIdx[inst.get()] = idx;
+				return OB_STUDIO_REF_EXTERNAL | idx;
+			}
+		};
+
+		// Properties written for a class, everything that can be set
+		// back other than Parent, which has its own chunk.
+		static ColumnList ob_studio_binary_columns(shared_ptr<Instance::Instance> inst){
+			ColumnList cols;
+
+			std::map<std::string, Instance::_PropertyInfo> props = inst->getProperties();
+			for(auto it = props.begin(); it != props.end(); ++it){
+				if(it->second.readOnly || it->first == "Parent"){
+					continue;
+				}
+
+				PropertyType type = ob_studio_property_type(it->second.type);
+				if(type != PropertyType::Unknown){
+					cols.push_back(std::make_pair(it->first, type));
+				}
+			}
+
+			return cols;
+		}
+
+		static void ob_studio_write_chunk(QDataStream& out, quint32 tag, const QByteArray& payload, bool compress){
+			QByteArray stored = payload;
+			quint32 flags = 0;
+
+			if(compress && payload.size() > OB_STUDIO_CHUNK_MIN_COMPRESS){
+				QByteArray compressed = qCompress(payload, 1);
+				if(compressed.size() < payload.size()){
+					stored = compressed;
+					flags |= OB_STUDIO_CHUNK_COMPRESSED;
+				}
+			}
+
+			out << tag << flags << (quint32)payload.size() << (quint32)stored.size();
+			out.writeRawData(stored.constData(), stored.size());
+		}
+
+		static void ob_studio_setup_stream(QDataStream& stream){
+			stream.setByteOrder(QDataStream::LittleEndian);
+			stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+		}
+
+		static void ob_studio_write_value(QDataStream& out, PropertyType type, shared_ptr<Type::VarWrapper> val, RefTable& refs){
+			switch(type){
+				case PropertyType::String: {
+					std::string str = val ? val->asString() : "";
+					out << QByteArray::fromRawData(str.data(), str.size());
+					break;
+				}
+				case PropertyType::Bool: {
+					out << (quint8)(val ? val->asBool() : false);
+					break;
+				}
+				case PropertyType::Int: {
+					out << (qint32)(val ? val->asInt() : 0);
+					break;
+				}
+				case PropertyType::Double: {
+					out << (double)(val ? val->asDouble() : 0);
+					break;
+				}
+				case PropertyType::Float: {
+					out << (double)(val ? val->asFloat() : 0);
+					break;
+				}
+				case PropertyType::Color3: {
+					shared_ptr<Type::Color3> col = val ? val->asColor3() : NULL;
+					if(col){
+						out << col->getR() << col->getG() << col->getB();
+					}else{
+						out << 0.0 << 0.0 << 0.0;
+					}
+					break;
+				}
+				case PropertyType::Vector3: {
+					shared_ptr<Type::Vector3> vec = val ? val->asVector3() : NULL;
+					if(vec){
+						out << vec->getX() << vec->getY() << vec->getZ();
+					}else{
+						out << 0.0 << 0.0 << 0.0;
+					}
+					break;
+				}
+				case PropertyType::Vector2: {
+					shared_ptr<Type::Vector2> vec = val ? val->asVector2() : NULL;
+					if(vec){
+						out << vec->getX() << vec->getY();
+					}else{
+						out << 0.0 << 0.0;
+					}
+					break;
+				}
+				case PropertyType::UDim: {
+					shared_ptr<Type::UDim> ud = val ? val->asUDim() : NULL;
+					if(ud){
+						out << ud->getScale() << ud->getOffset();
+					}else{
+						out << 0.0 << 0.0;
+					}
+					break;
+				}
+				case PropertyType::UDim2: {
+					shared_ptr<Type::UDim2> ud = val ? val->asUDim2() : NULL;
+					shared_ptr<Type::UDim> uX = ud ? ud->getX() : NULL;
+					shared_ptr<Type::UDim> uY = ud ? ud->getY() : NULL;
+					out << (uX ? uX->getScale() : 0.0) << (uX ? uX->getOffset() : 0.0);
+					out << (uY ? uY->getScale() : 0.0) << (uY ? uY->getOffset() : 0.0);
+					break;
+				}
+				case PropertyType::Instance: {
+					out << refs.refFor(val ? val->asInstance() : NULL);
+					break;
+				}
+				default: {
+					break;
+				}
+			}
+		}
+
+		// Instance values are returned as a referent in refId, they
+		// can only be resolved once every instance exists.
+		static shared_ptr<Type::VarWrapper> ob_studio_read_value(QDataStream& in, PropertyType type, quint32* refId){
+			switch(type){
+				case PropertyType::String: {
+					QByteArray str;
+					in >> str;
+					return make_shared<Type::VarWrapper>(std::string(str.constData(), str.size()));
+				}
+				case PropertyType::Bool: {
+					quint8 b;
+					in >> b;
+					return make_shared<Type::VarWrapper>(b != 0);
+				}
+				case PropertyType::Int: {
+					qint32 i;
+					in >> i;
+					return make_shared<Type::VarWrapper>((int)i);
+				}
+				case PropertyType::Double: {
+					double d;
+					in >> d;
+					return make_shared<Type::VarWrapper>(d);
+				}
+				case PropertyType::Float: {
+					double d;
+					in >> d;
+					return make_shared<Type::VarWrapper>((float)d);
+				}
+				case PropertyType::Color3: {
+					double r, g, b;
+					in >> r >> g >> b;
+					return make_shared<Type::VarWrapper>(make_shared<Type::Color3>(r, g, b));
+				}
+				case PropertyType::Vector3: {
+					double x, y, z;
+					in >> x >> y >> z;
+					return make_shared<Type::VarWrapper>(make_shared<Type::Vector3>(x, y, z));
+				}
+				case PropertyType::Vector2: {
+					double x, y;
+					in >> x >> y;
+					return make_shared<Type::VarWrapper>(make_shared<Type::Vector2>(x, y));
+				}
+				case PropertyType::UDim: {
+					double scale, offset;
+					in >> scale >> offset;
+					return make_shared<Type::VarWrapper>(make_shared<Type::UDim>(scale, offset));
+				}
+				case PropertyType::UDim2: {
+					double xScale, xOffset, yScale, yOffset;
+					in >> xScale >> xOffset >> yScale >> yOffset;
+					return make_shared<Type::VarWrapper>(make_shared<Type::UDim2>(xScale, xOffset, yScale, yOffset));
+				}
+				case PropertyType::Instance: {
+					in >> *refId;
+					return NULL;
+				}
+				default: {
+					return NULL;
+				}
+			}
+		}
+
+		bool BinaryPlace::isBinary(const char* data, qint64 size){
+			return size >= 4 && memcmp(data, ob_studio_binary_magic, 4) == 0;
+		}
+
+		bool BinaryPlace::save(OBEngine* eng, bool compress, QByteArray* out, QString* error, std::vector<SavedInstance>* saved){
+			shared_ptr<Instance::DataModel> dm = eng->getDataModel();
+			if(!dm){
+				*error = "Failed to serialize game.";
+				return false;
+			}
+
+			return saveInstances(dm->GetChildren(), compress, out, error, saved);
+		}
+
+		void BinaryPlace::walk(std::vector<shared_ptr<Instance::Instance>> roots, std::vector<SavedInstance>* out){
+			std::vector<std::pair<shared_ptr<Instance::Instance>, quint32>> toVisit;
+			for(auto it = roots.rbegin(); it != roots.rend(); ++it){
+				toVisit.push_back(std::make_pair(*it, OB_STUDIO_REF_NONE));
+			}
+
+			while(!toVisit.empty()){
+				shared_ptr<Instance::Instance> inst = toVisit.back().first;
+				quint32 parentRef = toVisit.back().second;
+				toVisit.pop_back();
+
+				if(!inst || !inst->getArchivable()){
+					continue;
+				}
+
+				quint32 ref = out->size();
+				SavedInstance entry;
+				entry.inst = inst;
+				entry.parent = parentRef;
+				out->push_back(entry);
+
+				std::vector<shared_ptr<Instance::Instance>> kids = inst->GetChildren();
+				for(auto it = kids.rbegin(); it != kids.rend(); ++it){
+					toVisit.push_back(std::make_pair(*it, ref));
+				}
+			}
+		}
+
+		void BinaryPlace::walkGame(OBEngine* eng, std::vector<SavedInstance>* out){
+			shared_ptr<Instance::DataModel> dm = eng->getDataModel();
+			if(!dm){
+				return;
+			}
+
+			std::vector<shared_ptr<Instance::Instance>> services = dm->GetChildren();
+			services.erase(std::remove(services.begin(), services.end(), shared_ptr<Instance::Instance>()), services.end());
+			std::stable_sort(services.begin(), services.end(), [](const shared_ptr<Instance::Instance>& a, const shared_ptr<Instance::Instance>& b){
+				return a->getClassName() < b->getClassName();
+			});
+
+			walk(services, out);
+		}
+
+		bool BinaryPlace::saveInstances(std::vector<shared_ptr<Instance::Instance>> roots, bool compress, QByteArray* out, QString* error, std::vector<SavedInstance>* saved, RefNamer namer){
+			// Walk the tree, parents always come before their children
+			std::vector<SavedInstance> walked;
+			walk(roots, &walked);
+
+			std::vector<shared_ptr<Instance::Instance>> insts;
+			std::vector<quint32> parents;
+			RefTable refs;
+			refs.namer = namer;
+
+			insts.reserve(walked.size());
+			parents.reserve(walked.size());
+			for(size_t i = 0; i < walked.size(); i++){
+				insts.push_back(walked[i].inst);
+				parents.push_back(walked[i].parent);
+				refs.refs[walked[i].inst.get()] = i;
+			}
+
+			// Group by class, in the order classes first show up
+			std::vector<std::string> strings;
+			std::unordered_map<std::string, quint32> stringIdx;
+			auto intern = [&strings, &stringIdx](const std::string& str) -> quint32 {
+				auto it = stringIdx.find(str);
+				if(it != stringIdx.end()){
+					return it->second;
+				}
+				quint32 idx = strings.size();
+				strings.push_back(str);
+				stringIdx[str] = idx;
+				return idx;
+			};
+
+			std::vector<std::vector<quint32>> classInsts;
+			std::unordered_map<std::string, size_t> classIdx;
+			std::vector<std::string> classNames;
+			for(size_t i = 0; i < insts.size(); i++){
+				std::string className = insts[i]->getClassName();
+				auto it = classIdx.find(className);
+				if(it == classIdx.end()){
+					it = classIdx.insert(std::make_pair(className, classInsts.size())).first;
+					classInsts.push_back(std::vector<quint32>());
+					classNames.push_back(className);
+				}
+				classInsts[it->second].push_back(i);
+			}
+
+			// Instance chunks are built first so the string table knows
+			// every name, but it has to come first in the file.
+			std::vector<QByteArray> instChunks;
+			for(size_t c = 0; c < classInsts.size(); c++){
+				const std::vector<quint32>& members = classInsts[c];
+				ColumnList cols = ob_studio_binary_columns(insts[members[0]]);
+
+				QByteArray payload;
+				QDataStream chunk(&payload, QIODevice::WriteOnly);
+				ob_studio_setup_stream(chunk);
+
+				chunk << intern(classNames[c]) << (quint32)members.size();
+				for(size_t i = 0; i < members.size(); i++){
+					chunk << members[i];
+				}
+
+				chunk << (quint32)cols.size();
+				for(size_t p = 0; p < cols.size(); p++){
+					chunk << intern(cols[p].first) << (quint8)cols[p].second;
+
+					for(size_t i = 0; i < members.size(); i++){
+						shared_ptr<Type::VarWrapper> val;
+						try{
+							val = insts[members[i]]->getProperty(cols[p].first);
+						}catch(OBException* ex){
+							val = NULL;
+						}
+						ob_studio_write_value(chunk, cols[p].second, val, refs);
+					}
+				}
+
+				instChunks.push_back(payload);
+			}
+
+			out->clear();
+			QDataStream file(out, QIODevice::WriteOnly);
+			ob_studio_setup_stream(file);
+
+			file.writeRawData(ob_studio_binary_magic, 4);
+			file << (quint16)OB_STUDIO_BINARY_PLACE_VERSION << (quint16)0;
+
+			QByteArray strs;
+			{
+				QDataStream chunk(&strs, QIODevice::WriteOnly);
+				ob_studio_setup_stream(chunk);
+
+				chunk << (quint32)strings.size();
+				for(size_t i = 0; i < strings.size(); i++){
+					chunk << QByteArray::fromRawData(strings[i].data(), strings[i].size());
+				}
+			}
+			ob_studio_write_chunk(file, OB_STUDIO_CHUNK_STRS, strs, compress);
+
+			for(size_t i = 0; i < instChunks.size(); i++){
+				ob_studio_write_chunk(file, OB_STUDIO_CHUNK_INST, instChunks[i], compress);
+			}
+
+			if(!refs.externals.empty()){
+				QByteArray extr;
+				QDataStream chunk(&extr, QIODevice::WriteOnly);
+				ob_studio_setup_stream(chunk);
+
+				chunk << (quint32)refs.externals.size();
+				for(size_t i = 0; i < refs.externals.size(); i++){
+					chunk << refs.externals[i];
+				}
+				ob_studio_write_chunk(file, OB_STUDIO_CHUNK_EXTR, extr, compress);
+			}
+
+			QByteArray prnt;
+			{
+				QDataStream chunk(&prnt, QIODevice::WriteOnly);
+				ob_studio_setup_stream(chunk);
+
+				chunk << (quint32)parents.size();
+				for(size_t i = 0; i < parents.size(); i++){
+					chunk << (quint32)i << parents[i];
+				}
+			}
+			ob_studio_write_chunk(file, OB_STUDIO_CHUNK_PRNT, prnt, compress);
+
+			ob_studio_write_chunk(file, OB_STUDIO_CHUNK_END, QByteArray(), false);
+
+			if(saved){
+				saved->swap(walked);
+			}
+
+			return true;
+		}
+
+		bool BinaryPlace::load(OBEngine* eng, const char* data, qint64 size, QString* error){
+			shared_ptr<Instance::DataModel> dm = eng->getDataModel();
+			if(!dm){
+				*error = "No game to load into.";
+				return false;
+			}
+
+			return loadInto(eng, dm, data, size, error);
+		}
+
+		bool BinaryPlace::loadInto(OBEngine* eng, shared_ptr<Instance::Instance> parent, const char* data, qint64 size, QString* error, std::vector<shared_ptr<Instance::Instance>>* newRoots, std::vector<shared_ptr<Instance::Instance>>* loaded, RefBinder binder){
+			shared_ptr<Instance::DataModel> dm = eng->getDataModel();
+			if(!dm){
+				*error = "No game to load into.";
+				return false;
+			}
+
+			if(!isBinary(data, size)){
+				*error = "Not a binary place file.";
+				return false;
+			}
+
+			QByteArray raw = QByteArray::fromRawData(data, size);
+			QDataStream file(raw);
+			ob_studio_setup_stream(file);
+			file.skipRawData(4);
+
+			quint16 version, fileFlags;
+			file >> version >> fileFlags;
+			if(version > OB_STUDIO_BINARY_PLACE_VERSION){
+				*error = "This place was saved by a newer version of OpenBlox Studio.";
+				return false;
+			}
+
+			std::vector<std::string> strings;
+			std::unordered_map<quint32, shared_ptr<Instance::Instance>> insts;
+
+			struct PendingRef{
+				shared_ptr<Instance::Instance> inst;
+				std::string prop;
+				quint32 ref;
+			};
+			std::vector<PendingRef> pendingRefs;
+
+			std::vector<QByteArray> externals;
+			std::vector<std::pair<quint32, quint32>> parents;
+
+			bool sawEnd = false;
+			while(!sawEnd){
+				quint32 tag, flags, rawSize, storedSize;
+				file >> tag >> flags >> rawSize >> storedSize;
+				if(file.status() != QDataStream::Ok || file.device()->pos() + storedSize > size){
+					*error = "Place file is truncated.";
+					return false;
+				}
+
+				QByteArray payload = QByteArray::fromRawData(data + file.device()->pos(), storedSize);
+				file.skipRawData(storedSize);
+
+				if(flags & OB_STUDIO_CHUNK_COMPRESSED){
+					payload = qUncompress(payload);
+					if((quint32)payload.size() != rawSize){
+						*error = "Place file is corrupt.";
+						return false;
+					}
+				}
+
+				QDataStream chunk(payload);
+				ob_studio_setup_stream(chunk);
+
+				switch(tag){
+					case OB_STUDIO_CHUNK_STRS: {
+						// Every string takes at least its length, so a count
+						// the payload can't hold is corrupt, not a huge reserve
+						quint32 count;
+						chunk >> count;
+						if(count > (quint32)payload.size() / 4){
+							*error = "Place file is corrupt.";
+							return false;
+						}
+						strings.reserve(count);
+						for(quint32 i = 0; i < count && chunk.status() == QDataStream::Ok; i++){
+							QByteArray str;
+							chunk >> str;
+							strings.push_back(std::string(str.constData(), str.size()));
+						}
+						break;
+					}
+					case OB_STUDIO_CHUNK_INST: {
+						quint32 classNameIdx, count;
+						chunk >> classNameIdx >> count;
+						if(classNameIdx >= strings.size() || count > (quint32)payload.size() / 4){
+							*error = "Place file is corrupt.";
+							return false;
+						}
+						std::string className = strings[classNameIdx];
+
+						std::vector<quint32> refIds(count);
+						std::vector<shared_ptr<Instance::Instance>> members(count);
+						for(quint32 i = 0; i < count; i++){
+							chunk >> refIds[i];
+
+							// Services already exist, everything else is new
+							shared_ptr<Instance::Instance> inst;
+							if(ClassFactory::canCreate(className)){
+								inst = ClassFactory::create(className, eng);
+							}else{
+								inst = dm->GetService(className);
+							}
+							members[i] = inst;
+							if(inst){
+								insts[refIds[i]] = inst;
+							}
+						}
+
+						quint32 propCount;
+						chunk >> propCount;
+						for(quint32 p = 0; p < propCount && chunk.status() == QDataStream::Ok; p++){
+							quint32 propNameIdx;
+							quint8 typeId;
+							chunk >> propNameIdx >> typeId;
+							if(propNameIdx >= strings.size() || typeId >= (quint8)PropertyType::Count){
+								*error = "Place file is corrupt.";
+								return false;
+							}
+							const std::string& propName = strings[propNameIdx];
+							PropertyType type = (PropertyType)typeId;
+
+							for(quint32 i = 0; i < count; i++){
+								quint32 ref = OB_STUDIO_REF_NONE;
+								shared_ptr<Type::VarWrapper> val = ob_studio_read_value(chunk, type, &ref);
+
+								shared_ptr<Instance::Instance> inst = members[i];
+								if(!inst){
+									continue;
+								}
+
+								if(type == PropertyType::Instance){
+									if(ref != OB_STUDIO_REF_NONE){
+										PendingRef pending;
+										pending.inst = inst;
+										pending.prop = propName;
+										pending.ref = ref;
+										pendingRefs.push_back(pending);
+									}
+									continue;
+								}
+
+								try{
+									inst->setProperty(propName, val);
+								}catch(OBException* ex){
+									// Properties this version can't set are skipped
+								}
+							}
+						}
+						break;
+					}
+					case OB_STUDIO_CHUNK_EXTR: {
+						quint32 count;
+						chunk >> count;
+						if(count > (quint32)payload.size() / 4){
+							*error = "Place file is corrupt.";
+							return false;
+						}
+						externals.reserve(count);
+						for(quint32 i = 0; i < count && chunk.status() == QDataStream::Ok; i++){
+							QByteArray key;
+							chunk >> key;
+							externals.push_back(key);
+						}
+						break;
+					}
+					case OB_STUDIO_CHUNK_PRNT: {
+						quint32 count;
+						chunk >> count;
+						if(count > (quint32)payload.size() / 8){
+							*error = "Place file is corrupt.";
+							return false;
+						}
+						parents.reserve(count);
+						for(quint32 i = 0; i < count && chunk.status() == QDataStream::Ok; i++){
+							quint32 child, parent;
+							chunk >> child >> parent;
+							parents.push_back(std::make_pair(child, parent));
+						}
+						break;
+					}
+					case OB_STUDIO_CHUNK_END: {
+						sawEnd = true;
+						break;
+					}
+					default: {
+						// Unknown chunks are from newer versions, skip them
+						break;
+					}
+				}
+
+				if(chunk.status() != QDataStream::Ok){
+					*error = "Place file is corrupt.";
+					return false;
+				}
+			}
+
+			for(size_t i = 0; i < pendingRefs.size(); i++){
+				quint32 ref = pendingRefs[i].ref;
+				if(ref & OB_STUDIO_REF_EXTERNAL){
+					quint32 ext = ref & ~OB_STUDIO_REF_EXTERNAL;
+					if(binder && ext < externals.size()){
+						binder(pendingRefs[i].inst, pendingRefs[i].prop, externals[ext]);
+					}
+					continue;
+				}
+
+				auto it = insts.find(ref);
+				if(it != insts.end()){
+					try{
+						pendingRefs[i].inst->setProperty(pendingRefs[i].prop, make_shared<Type::VarWrapper>(it->second));
+					}catch(OBException* ex){}
+				}
+			}
+
+			// Build each subtree before attaching it to the game, so
+			// the game only sees one ChildAdded per new root
+			std::vector<std::pair<shared_ptr<Instance::Instance>, shared_ptr<Instance::Instance>>> roots;
+			for(size_t i = 0; i < parents.size(); i++){
+				auto cIt = insts.find(parents[i].first);
+				if(cIt == insts.end()){
+					continue;
+				}
+				shared_ptr<Instance::Instance> child = cIt->second;
+
+				if(parents[i].second == OB_STUDIO_REF_NONE){
+					// Services are already in the game
+					if(!child->getParent()){
+						if(newRoots){
+							newRoots->push_back(child);
+						}
+						if(parent){
+							roots.push_back(std::make_pair(child, parent));
+						}
+					}
+					continue;
+				}
+
+				auto pIt = insts.find(parents[i].second);
+				if(pIt == insts.end()){
+					continue;
+				}
+				shared_ptr<Instance::Instance> newParent = pIt->second;
+
+				if(newParent->getParent() && !ClassFactory::canCreate(newParent->getClassName())){
+					roots.push_back(std::make_pair(child, newParent));
+				}else{
+					child->setParent(newParent, false);
+				}
+			}
+
+			for(size_t i = 0; i < roots.size(); i++){
+				roots[i].first->setParent(roots[i].second, false);
+			}
+
+			if(loaded){
+				loaded->assign(parents.size(), NULL);
+				for(size_t i = 0; i < parents.size(); i++){
+					auto it = insts.find(parents[i].first);
+					if(parents[i].first < parents.size() && it != insts.end()){
+						(*loaded)[parents[i].first] = it->second;
+					}
+				}
+			}
+
+			return true;
+		}
+
+		void BinaryPlace::saveProperties(shared_ptr<Instance::Instance> inst, const std::vector<std::string>& props, RefNamer namer, QByteArray* out){
+			ColumnList cols = ob_studio_binary_columns(inst);
+
+			RefTable noRefs;
+
+			out->clear();
+			QDataStream stream(out, QIODevice::WriteOnly);
+			ob_studio_setup_stream(stream);
+
+			quint32 count = 0;
+			stream << count;
+
+			for(size_t c = 0; c < cols.size(); c++){
+				if(std::find(props.begin(), props.end(), cols[c].first) == props.end()){
+					continue;
+				}
+
+				shared_ptr<Type::VarWrapper> val;
+				try{
+					val = inst->getProperty(cols[c].first);
+				}catch(OBException* ex){
+					continue;
+				}
+
+				stream << QByteArray::fromRawData(cols[c].first.data(), cols[c].first.size()) << (quint8)cols[c].second;
+				if(cols[c].second == PropertyType::Instance){
+					shared_ptr<Instance::Instance> ref = val ? val->asInstance() : NULL;
+					stream << (ref && namer ? namer(ref) : QByteArray());
+				}else{
+					ob_studio_write_value(stream, cols[c].second, val, noRefs);
+				}
+				count++;
+			}
+
+			stream.device()->seek(0);
+			stream << count;
+		}
+
+		bool BinaryPlace::loadProperties(shared_ptr<Instance::Instance> inst, const char* data, qint64 size, RefBinder binder, QString* error){
+			QByteArray raw = QByteArray::fromRawData(data, size);
+			QDataStream stream(raw);
+			ob_studio_setup_stream(stream);
+
+			quint32 count;
+			stream >> count;
+			for(quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++){
+				QByteArray name;
+				quint8 typeId;
+				stream >> name >> typeId;
+				if(typeId >= (quint8)PropertyType::Count){
+					*error = "Place file is corrupt.";
+					return false;
+				}
+				std::string propName(name.constData(), name.size());
+				PropertyType type = (PropertyType)typeId;
+
+				if(type == PropertyType::Instance){
+					QByteArray key;
+					stream >> key;
+					if(key.isEmpty()){
+						try{
+							inst->setProperty(propName, make_shared<Type::VarWrapper>(shared_ptr<Instance::Instance>()));
+						}catch(OBException* ex){}
+					}else if(binder){
+						binder(inst, propName, key);
+					}
+					continue;
+				}
+
+				quint32 ref;
+				shared_ptr<Type::VarWrapper> val = ob_studio_read_value(stream, type, &ref);
+				try{
+					inst->setProperty(propName, val);
+				}catch(OBException* ex){}
+			}
+
+			if(stream.status() != QDataStream::Ok){
+				*error = "Place file is truncated.";
+				return false;
+			}
+			return true;
+		}
+	}
+}
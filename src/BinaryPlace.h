@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OB_STUDIO_BINARYPLACE_H_
+#define OB_STUDIO_BINARYPLACE_H_
+
+#include <QByteArray>
+#include <QString>
+
+#include <OBEngine.h>
+#include <instance/Instance.h>
+
+#include <vector>
+#include <functional>
+
+#define OB_STUDIO_BINARY_PLACE_SUFFIX "obgb"
+#define OB_STUDIO_BINARY_PLACE_VERSION 1
+
+// Referent of the DataModel, or of a missing Instance value
+#define OB_STUDIO_REF_NONE 0xFFFFFFFF
+
+namespace OB{
+	namespace Studio{
+		/*
+		 * Binary place format, an alternative to the engine's XML.
+		 *
+		 * The file is a header ("OBGB", version, flags) followed by
+		 * chunks, each a tag, flags, raw size, stored size and the
+		 * payload, which may be zlib compressed:
+		 *
+		 *  STRS  string table of class and property names
+		 *  INST  one per class: referent ids, then one typed column
+		 *        per property holding that property for every
+		 *        instance of the class
+		 *  EXTR  keys of Instance values outside what was saved
+		 *  PRNT  (child, parent) referent pairs in tree order
+		 *  END   end of file
+		 *
+		 * Referents are the order instances are walked in, parents
+		 * before their children. Both directions expect the caller to
+		 * hold the engine.
+		 */
+		class BinaryPlace{
+		public:
+			// An instance that was written, and its parent's referent
+			struct SavedInstance{
+				shared_ptr<Instance::Instance> inst;
+				quint32 parent;
+			};
+
+			// Instance values that point outside what's being saved are
+			// normally dropped. A namer can give them a key instead,
+			// which the loader hands to a binder along with the instance
+			// and property it belongs to.
+			typedef std::function<QByteArray(shared_ptr<Instance::Instance>)> RefNamer;
+			typedef std::function<void(shared_ptr<Instance::Instance>, const std::string&, const QByteArray&)> RefBinder;
+
+			static bool isBinary(const char* data, qint64 size);
+
+			static bool save(OBEngine* eng, bool compress, QByteArray* out, QString* error, std::vector<SavedInstance>* saved = NULL);
+			static bool load(OBEngine* eng, const char* data, qint64 size, QString* error);
+
+			// Just the given subtrees, loaded back under parent. With
+			// no parent the new roots are left for the caller to place.
+			// loaded gets what was created, indexed by referent.
+			static bool saveInstances(std::vector<shared_ptr<Instance::Instance>> roots, bool compress, QByteArray* out, QString* error, std::vector<SavedInstance>* saved = NULL, RefNamer namer = RefNamer());
+			static bool loadInto(OBEngine* eng, shared_ptr<Instance::Instance> parent, const char* data, qint64 size, QString* error, std::vector<shared_ptr<Instance::Instance>>* newRoots = NULL, std::vector<shared_ptr<Instance::Instance>>* loaded = NULL, RefBinder binder = RefBinder());
+
+			// What saveInstances would write, in referent order
+			static void walk(std::vector<shared_ptr<Instance::Instance>> roots, std::vector<SavedInstance>* out);
+
+			// The whole game, with services in an order that doesn't
+			// depend on which of them happened to be created first
+			static void walkGame(OBEngine* eng, std::vector<SavedInstance>* out);
+
+			// Some properties of one instance, without its children.
+			// Every Instance value goes through the namer and binder.
+			static void saveProperties(shared_ptr<Instance::Instance> inst, const std::vector<std::string>& props, RefNamer namer, QByteArray* out);
+			static bool loadProperties(shared_ptr<Instance::Instance> inst, const char* data, qint64 size, RefBinder binder, QString* error);
+		};
+	}
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,522 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Round-trip checks for the binary place format, run by `make check'.
+ *
+ * A place is built with an instance of every class that can be
+ * created, each property set to a value that differs from the last,
+ * and saved and loaded back both through BinaryPlace and through the
+ * engine's XML serializer. The loaded trees have to match the
+ * original, and cut short or damaged binary files have to fail to
+ * load instead of crashing or loading something else.
+ */
+
+#include "BinaryPlace.h"
+#include "PropertySchema.h"
+
+#include <openblox.h>
+#include <OBSerializer.h>
+#include <OBException.h>
+
+#include <instance/Instance.h>
+#include <instance/DataModel.h>
+
+#include <type/Color3.h>
+#include <type/Vector3.h>
+#include <type/Vector2.h>
+#include <type/UDim.h>
+#include <type/UDim2.h>
+
+#include <QtEndian>
+
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <set>
+
+#define OB_STUDIO_TEST_ROOT "BinaryPlaceTest"
+
+using namespace OB;
+using namespace OB::Studio;
+
+static int ob_studio_failures = 0;
+
+static void ob_studio_check(bool ok, const std::string& what){
+	if(!ok){
+		fprintf(stderr, "FAIL: %s\n", what.c_str());
+		ob_studio_failures++;
+	}
+}
+
+static const char* ob_studio_type_name(PropertyType type){
+	switch(type){
+		case PropertyType::String: return "String";
+		case PropertyType::Bool: return "Bool";
+		case PropertyType::Int: return "Int";
+		case PropertyType::Double: return "Double";
+		case PropertyType::Float: return "Float";
+		case PropertyType::Color3: return "Color3";
+		case PropertyType::Vector3: return "Vector3";
+		case PropertyType::Vector2: return "Vector2";
+		case PropertyType::UDim: return "UDim";
+		case PropertyType::UDim2: return "UDim2";
+		case PropertyType::Instance: return "Instance";
+		default: return "Unknown";
+	}
+}
+
+static OBEngine* ob_studio_new_engine(){
+	OBEngine* eng = new OBEngine();
+	eng->setRendering(false);
+	eng->init();
+	return eng;
+}
+
+// The same columns BinaryPlace writes
+static std::vector<std::pair<std::string, PropertyType>> ob_studio_columns(shared_ptr<Instance::Instance> inst){
+	std::vector<std::pair<std::string, PropertyType>> cols;
+
+	std::map<std::string, Instance::_PropertyInfo> props = inst->getProperties();
+	for(auto it = props.begin(); it != props.end(); ++it){
+		if(it->second.readOnly || it->first == "Parent"){
+			continue;
+		}
+
+		PropertyType type = ob_studio_property_type(it->second.type);
+		if(type != PropertyType::Unknown){
+			cols.push_back(std::make_pair(it->first, type));
+		}
+	}
+
+	return cols;
+}
+
+// Names are unique under the test root, so a path identifies an
+// instance in any copy of the place.
+static std::string ob_studio_path(shared_ptr<Instance::Instance> inst){
+	if(!inst){
+		return "<nil>";
+	}
+
+	std::string path;
+	while(inst && inst->getParent()){
+		path = "." + inst->getName() + path;
+		inst = inst->getParent();
+	}
+	return inst ? "game" + path : "<detached>" + path;
+}
+
+static shared_ptr<Instance::Instance> ob_studio_find_child(shared_ptr<Instance::Instance> parent, const std::string& name){
+	if(!parent){
+		return NULL;
+	}
+
+	std::vector<shared_ptr<Instance::Instance>> kids = parent->GetChildren();
+	for(size_t i = 0; i < kids.size(); i++){
+		if(kids[i] && kids[i]->getName() == name){
+			return kids[i];
+		}
+	}
+	return NULL;
+}
+
+static shared_ptr<Instance::Instance> ob_studio_test_root(OBEngine* eng){
+	shared_ptr<Instance::DataModel> dm = eng->getDataModel();
+	if(!dm){
+		return NULL;
+	}
+	return ob_studio_find_child(dm->GetService("Workspace"), OB_STUDIO_TEST_ROOT);
+}
+
+// A value of the given type that no earlier call returned
+static shared_ptr<Type::VarWrapper> ob_studio_test_value(PropertyType type, int seed, shared_ptr<Instance::Instance> ref){
+	double frac = (seed % 7 + 1) / 8.0;
+
+	switch(type){
+		case PropertyType::String: {
+			return make_shared<Type::VarWrapper>(std::string("value ") + std::to_string(seed));
+		}
+		case PropertyType::Bool: {
+			return make_shared<Type::VarWrapper>(seed % 2 == 1);
+		}
+		case PropertyType::Int: {
+			return make_shared<Type::VarWrapper>(seed);
+		}
+		case PropertyType::Double: {
+			return make_shared<Type::VarWrapper>(seed + 0.25);
+		}
+		case PropertyType::Float: {
+			return make_shared<Type::VarWrapper>((float)(seed + 0.5));
+		}
+		case PropertyType::Color3: {
+			return make_shared<Type::VarWrapper>(make_shared<Type::Color3>(frac, 1 - frac, frac / 2));
+		}
+		case PropertyType::Vector3: {
+			return make_shared<Type::VarWrapper>(make_shared<Type::Vector3>(seed, seed + 0.5, -seed));
+		}
+		case PropertyType::Vector2: {
+			return make_shared<Type::VarWrapper>(make_shared<Type::Vector2>(seed, -seed - 0.5));
+		}
+		case PropertyType::UDim: {
+			return make_shared<Type::VarWrapper>(make_shared<Type::UDim>(frac, seed));
+		}
+		case PropertyType::UDim2: {
+			return make_shared<Type::VarWrapper>(make_shared<Type::UDim2>(frac, seed, 1 - frac, -seed));
+		}
+		case PropertyType::Instance: {
+			return make_shared<Type::VarWrapper>(ref);
+		}
+		default: {
+			return NULL;
+		}
+	}
+}
+
+/*
+ * Puts one of every creatable class under a folder in Workspace and
+ * sets every property it can. Instance properties alternate between
+ * the instance before it, inside the folder, and Workspace itself,
+ * outside of it. Returns the column types that were covered.
+ */
+static std::set<PropertyType> ob_studio_populate(OBEngine* eng){
+	std::set<PropertyType> covered;
+
+	shared_ptr<Instance::DataModel> dm = eng->getDataModel();
+	shared_ptr<Instance::Instance> ws = dm ? dm->GetService("Workspace") : NULL;
+	ob_studio_check(ws != NULL, "the engine has a Workspace");
+	if(!ws){
+		return covered;
+	}
+
+	shared_ptr<Instance::Instance> root = ClassFactory::create("Folder", eng);
+	if(!root){
+		root = ClassFactory::create("Model", eng);
+	}
+	ob_studio_check(root != NULL, "a Folder or Model can be created");
+	if(!root){
+		return covered;
+	}
+	root->setName(OB_STUDIO_TEST_ROOT);
+	root->setParent(ws, false);
+
+	shared_ptr<Instance::Instance> last = root;
+	int seed = 1;
+
+	std::vector<std::string> classes = ClassFactory::getRegisteredClasses();
+	for(size_t c = 0; c < classes.size(); c++){
+		if(!ClassFactory::canCreate(classes[c])){
+			continue;
+		}
+
+		shared_ptr<Instance::Instance> inst = ClassFactory::create(classes[c], eng);
+		if(!inst){
+			continue;
+		}
+
+		try{
+			inst->setParent(root, false);
+		}catch(OBException* ex){
+			continue;
+		}
+		if(inst->getParent() != root){
+			continue;
+		}
+
+		std::vector<std::pair<std::string, PropertyType>> cols = ob_studio_columns(inst);
+		for(size_t p = 0; p < cols.size(); p++){
+			shared_ptr<Instance::Instance> ref = (seed % 2) ? last : ws;
+			try{
+				inst->setProperty(cols[p].first, ob_studio_test_value(cols[p].second, seed, ref));
+				covered.insert(cols[p].second);
+			}catch(OBException* ex){
+				// Not every value is valid for every property
+			}
+			seed++;
+		}
+
+		// Names have to stay unique for paths to mean anything
+		inst->setName(classes[c] + " " + std::to_string(seed++));
+		last = inst;
+	}
+
+	return covered;
+}
+
+static bool ob_studio_same_value(PropertyType type, shared_ptr<Type::VarWrapper> a, shared_ptr<Type::VarWrapper> b){
+	if(!a || !b){
+		return !a && !b;
+	}
+
+	switch(type){
+		case PropertyType::String: {
+			return a->asString() == b->asString();
+		}
+		case PropertyType::Bool: {
+			return a->asBool() == b->asBool();
+		}
+		case PropertyType::Int: {
+			return a->asInt() == b->asInt();
+		}
+		case PropertyType::Double: {
+			return a->asDouble() == b->asDouble();
+		}
+		case PropertyType::Float: {
+			return a->asFloat() == b->asFloat();
+		}
+		case PropertyType::Color3: {
+			shared_ptr<Type::Color3> ca = a->asColor3();
+			shared_ptr<Type::Color3> cb = b->asColor3();
+			if(!ca || !cb){
+				return !ca && !cb;
+			}
+			return ca->getR() == cb->getR() && ca->getG() == cb->getG() && ca->getB() == cb->getB();
+		}
+		case PropertyType::Vector3: {
+			shared_ptr<Type::Vector3> va = a->asVector3();
+			shared_ptr<Type::Vector3> vb = b->asVector3();
+			if(!va || !vb){
+				return !va && !vb;
+			}
+			return va->getX() == vb->getX() && va->getY() == vb->getY() && va->getZ() == vb->getZ();
+		}
+		case PropertyType::Vector2: {
+			shared_ptr<Type::Vector2> va = a->asVector2();
+			shared_ptr<Type::Vector2> vb = b->asVector2();
+			if(!va || !vb){
+				return !va && !vb;
+			}
+			return va->getX() == vb->getX() && va->getY() == vb->getY();
+		}
+		case PropertyType::UDim: {
+			shared_ptr<Type::UDim> ua = a->asUDim();
+			shared_ptr<Type::UDim> ub = b->asUDim();
+			if(!ua || !ub){
+				return !ua && !ub;
+			}
+			return ua->getScale() == ub->getScale() && ua->getOffset() == ub->getOffset();
+		}
+		case PropertyType::UDim2: {
+			shared_ptr<Type::UDim2> ua = a->asUDim2();
+			shared_ptr<Type::UDim2> ub = b->asUDim2();
+			if(!ua || !ub){
+				return !ua && !ub;
+			}
+			return ob_studio_same_value(PropertyType::UDim, make_shared<Type::VarWrapper>(ua->getX()), make_shared<Type::VarWrapper>(ub->getX())) &&
+				ob_studio_same_value(PropertyType::UDim, make_shared<Type::VarWrapper>(ua->getY()), make_shared<Type::VarWrapper>(ub->getY()));
+		}
+		case PropertyType::Instance: {
+			// Referents are compared by where they point
+			return ob_studio_path(a->asInstance()) == ob_studio_path(b->asInstance());
+		}
+		default: {
+			return true;
+		}
+	}
+}
+
+static shared_ptr<Type::VarWrapper> ob_studio_get(shared_ptr<Instance::Instance> inst, const std::string& prop){
+	try{
+		return inst->getProperty(prop);
+	}catch(OBException* ex){
+		return NULL;
+	}
+}
+
+// Walks both trees side by side, children in order
+static void ob_studio_compare(const std::string& via, shared_ptr<Instance::Instance> a, shared_ptr<Instance::Instance> b){
+	std::string where = via + ": " + ob_studio_path(a);
+
+	ob_studio_check(a->getClassName() == b->getClassName(), where + " has class " + b->getClassName() + ", not " + a->getClassName());
+	if(a->getClassName() != b->getClassName()){
+		return;
+	}
+
+	std::vector<std::pair<std::string, PropertyType>> cols = ob_studio_columns(a);
+	for(size_t p = 0; p < cols.size(); p++){
+		bool same = ob_studio_same_value(cols[p].second, ob_studio_get(a, cols[p].first), ob_studio_get(b, cols[p].first));
+		ob_studio_check(same, where + "." + cols[p].first + " (" + ob_studio_type_name(cols[p].second) + ") changed");
+	}
+
+	std::vector<shared_ptr<Instance::Instance>> aKids = a->GetChildren();
+	std::vector<shared_ptr<Instance::Instance>> bKids = b->GetChildren();
+	ob_studio_check(aKids.size() == bKids.size(), where + " has " + std::to_string(bKids.size()) + " children, not " + std::to_string(aKids.size()));
+
+	for(size_t i = 0; i < aKids.size() && i < bKids.size(); i++){
+		ob_studio_compare(via, aKids[i], bKids[i]);
+	}
+}
+
+static void ob_studio_check_loaded(const std::string& via, OBEngine* orig, OBEngine* loaded){
+	shared_ptr<Instance::Instance> a = ob_studio_test_root(orig);
+	shared_ptr<Instance::Instance> b = ob_studio_test_root(loaded);
+
+	ob_studio_check(b != NULL, via + ": the test folder was loaded");
+	if(a && b){
+		ob_studio_compare(via, a, b);
+	}
+}
+
+static void ob_studio_check_fails(const std::string& what, OBEngine* scratch, const QByteArray& data){
+	QString error;
+	bool loaded;
+	try{
+		loaded = BinaryPlace::loadInto(scratch, NULL, data.constData(), data.size(), &error);
+	}catch(OBException* ex){
+		loaded = false;
+		error = "Threw an exception.";
+	}
+
+	ob_studio_check(!loaded, what + " loads");
+	ob_studio_check(loaded || !error.isEmpty(), what + " fails without an error");
+}
+
+// Offset of the first chunk with the given tag, or -1
+static int ob_studio_chunk_offset(const QByteArray& data, const char* tag, bool compressed){
+	int pos = 8;
+	while(pos + 16 <= data.size()){
+		const uchar* hdr = (const uchar*)data.constData() + pos;
+		quint32 flags = qFromLittleEndian<quint32>(hdr + 4);
+		quint32 stored = qFromLittleEndian<quint32>(hdr + 12);
+
+		if(memcmp(hdr, tag, 4) == 0 && ((flags & 0x1) != 0) == compressed){
+			return pos;
+		}
+		pos += 16 + stored;
+	}
+	return -1;
+}
+
+static void ob_studio_check_damage(OBEngine* eng, OBEngine* scratch){
+	QByteArray plain, packed;
+	QString error;
+	ob_studio_check(BinaryPlace::save(eng, false, &plain, &error), "uncompressed save: " + std::string(error.toUtf8().constData()));
+	ob_studio_check(BinaryPlace::save(eng, true, &packed, &error), "compressed save: " + std::string(error.toUtf8().constData()));
+
+	// Cut short anywhere, including just before the END chunk
+	for(int i = 0; i < 16; i++){
+		ob_studio_check_fails("a file cut to " + std::to_string(i) + "/16", scratch, plain.left(plain.size() * i / 16));
+		ob_studio_check_fails("a compressed file cut to " + std::to_string(i) + "/16", scratch, packed.left(packed.size() * i / 16));
+	}
+	ob_studio_check_fails("a file missing its END chunk", scratch, plain.left(plain.size() - 16));
+
+	QByteArray bad = plain;
+	bad[0] = 'X';
+	ob_studio_check(!BinaryPlace::isBinary(bad.constData(), bad.size()), "a bad magic is still binary");
+
+	// Counts larger than their chunk could ever hold
+	const char* counted[] = {"STRS", "INST", "PRNT"};
+	for(size_t i = 0; i < sizeof(counted) / sizeof(counted[0]); i++){
+		int at = ob_studio_chunk_offset(plain, counted[i], false);
+		ob_studio_check(at >= 0, std::string("the file has an uncompressed ") + counted[i] + " chunk");
+		if(at < 0){
+			continue;
+		}
+
+		// INST counts come after the class name
+		int countAt = at + 16 + (i == 1 ? 4 : 0);
+		bad = plain;
+		qToLittleEndian<quint32>(0xFFFFFFF0, (uchar*)bad.data() + countAt);
+		ob_studio_check_fails(std::string("a huge ") + counted[i] + " count", scratch, bad);
+	}
+
+	// An unknown property type
+	int inst = ob_studio_chunk_offset(plain, "INST", false);
+	if(inst >= 0){
+		const uchar* payload = (const uchar*)plain.constData() + inst + 16;
+		quint32 count = qFromLittleEndian<quint32>(payload + 4);
+		int typeAt = inst + 16 + 8 + count * 4 + 4 + 4;
+		if(typeAt < plain.size() && qFromLittleEndian<quint32>(payload + 8 + count * 4) > 0){
+			bad = plain;
+			bad[typeAt] = (char)0xEE;
+			ob_studio_check_fails("an unknown property type", scratch, bad);
+		}
+	}
+
+	// Damage inside compressed data
+	int packedAt = ob_studio_chunk_offset(packed, "INST", true);
+	if(packedAt >= 0){
+		quint32 stored = qFromLittleEndian<quint32>((const uchar*)packed.constData() + packedAt + 12);
+		bad = packed;
+		bad[packedAt + 16 + stored / 2] = bad[packedAt + 16 + stored / 2] ^ 0x5A;
+		ob_studio_check_fails("damaged compressed data", scratch, bad);
+	}else{
+		printf("SKIP: no INST chunk was large enough to compress\n");
+	}
+}
+
+int main(){
+	OBEngine* eng = ob_studio_new_engine();
+	std::set<PropertyType> covered = ob_studio_populate(eng);
+
+	for(int t = (int)PropertyType::String; t < (int)PropertyType::Count; t++){
+		if(covered.find((PropertyType)t) == covered.end()){
+			printf("SKIP: no creatable class has a settable %s property\n", ob_studio_type_name((PropertyType)t));
+		}
+	}
+
+	// Binary, both with and without compression
+	for(int compress = 0; compress < 2; compress++){
+		std::string via = compress ? "compressed binary" : "binary";
+
+		QByteArray data;
+		QString error;
+		bool saved = BinaryPlace::save(eng, compress, &data, &error);
+		ob_studio_check(saved, via + " save: " + error.toUtf8().constData());
+		if(!saved){
+			continue;
+		}
+
+		OBEngine* loadEng = ob_studio_new_engine();
+		bool loaded = BinaryPlace::load(loadEng, data.constData(), data.size(), &error);
+		ob_studio_check(loaded, via + " load: " + error.toUtf8().constData());
+		if(loaded){
+			ob_studio_check_loaded(via, eng, loadEng);
+		}
+		delete loadEng;
+	}
+
+	// XML
+	{
+		shared_ptr<OBSerializer> serializer = eng->getSerializer();
+		std::string xml = serializer ? serializer->SaveInMemory_XML() : "";
+		ob_studio_check(!xml.empty(), "XML save");
+
+		OBEngine* loadEng = ob_studio_new_engine();
+		shared_ptr<OBSerializer> loader = loadEng->getSerializer();
+		if(loader && !xml.empty()){
+			loader->LoadFromMemory(xml.data(), xml.size());
+			ob_studio_check_loaded("XML", eng, loadEng);
+		}
+		delete loadEng;
+	}
+
+	OBEngine* scratch = ob_studio_new_engine();
+	ob_studio_check_damage(eng, scratch);
+	delete scratch;
+
+	delete eng;
+
+	if(ob_studio_failures){
+		fprintf(stderr, "%d checks failed\n", ob_studio_failures);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ClassIconTable.h"
+
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QPainter>
+#include <QVector>
+
+#include <openblox.h>
+
+#include <cmath>
+
+namespace OB{
+	namespace Studio{
+		static QHash<QString, int> ob_studio_class_slots;
+		static QHash<QString, int> ob_studio_path_slots;
+		static QVector<QIcon> ob_studio_slot_icons;
+		static QVector<QRect> ob_studio_slot_rects;
+		static QPixmap ob_studio_icon_atlas;
+
+		static QString ob_studio_icon_path(QString className){
+			return ":class_icons/" + className + ".png";
+		}
+
+		void ClassIconTable::build(){
+			ob_studio_class_slots.clear();
+			ob_studio_path_slots.clear();
+			ob_studio_slot_icons.clear();
+			ob_studio_slot_rects.clear();
+
+			// Every class's nearest icon, each distinct one numbered
+			std::vector<std::string> classes = ClassFactory::getRegisteredClasses();
+			QStringList paths;
+			for(size_t i = 0; i < classes.size(); i++){
+				QString className = QString(classes[i].c_str());
+
+				std::string cur = classes[i];
+				while(!cur.empty() && !QFile::exists(ob_studio_icon_path(QString(cur.c_str())))){
+					cur = ClassFactory::getParentClassName(cur);
+				}
+				if(cur.empty()){
+					ob_studio_class_slots.insert(className, -1);
+					continue;
+				}
+
+				QString path = ob_studio_icon_path(QString(cur.c_str()));
+				if(!ob_studio_path_slots.contains(path)){
+					ob_studio_path_slots.insert(path, paths.size());
+					paths.append(path);
+				}
+				ob_studio_class_slots.insert(className, ob_studio_path_slots.value(path));
+			}
+
+			// Square-ish grid of cells
+			const int sz = OB_STUDIO_CLASS_ICON_SIZE;
+			int cols = qMax(1, (int)std::ceil(std::sqrt((double)paths.size())));
+			int rows = qMax(1, (paths.size() + cols - 1) / cols);
+
+			QImage atlas(cols * sz, rows * sz, QImage::Format_ARGB32_Premultiplied);
+			atlas.fill(Qt::transparent);
+
+			QPainter painter(&atlas);
+			painter.setRenderHint(QPainter::SmoothPixmapTransform);
+			for(int i = 0; i < paths.size(); i++){
+				QRect cell((i % cols) * sz, (i / cols) * sz, sz, sz);
+
+				QImage img(paths[i]);
+				if(!img.isNull()){
+					if(img.width() != sz || img.height() != sz){
+						img = img.scaled(sz, sz, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+					}
+					painter.drawImage(cell.x() + (sz - img.width()) / 2, cell.y() + (sz - img.height()) / 2, img);
+				}
+
+				ob_studio_slot_rects.append(cell);
+			}
+			painter.end();
+
+			ob_studio_icon_atlas = QPixmap::fromImage(atlas);
+			for(int i = 0; i < ob_studio_slot_rects.size(); i++){
+				ob_studio_slot_icons.append(QIcon(ob_studio_icon_atlas.copy(ob_studio_slot_rects[i])));
+			}
+		}
+
+		int ClassIconTable::slotFor(QString className){
+			if(className.isEmpty()){
+				return -1;
+			}
+
+			auto it = ob_studio_class_slots.constFind(className);
+			if(it != ob_studio_class_slots.constEnd()){
+				return it.value();
+			}
+
+			// Registered after build(), resolve it once now
+			int slot;
+			QString path = ob_studio_icon_path(className);
+			if(ob_studio_path_slots.contains(path)){
+				slot = ob_studio_path_slots.value(path);
+			}else if(QFile::exists(path)){
+				// Not in the atlas, stands on its own
+				slot = ob_studio_slot_icons.size();
+				ob_studio_slot_icons.append(QIcon(path));
+				ob_studio_slot_rects.append(QRect());
+				ob_studio_path_slots.insert(path, slot);
+			}else{
+				slot = slotFor(QString(ClassFactory::getParentClassName(className.toStdString()).c_str()));
+			}
+
+			ob_studio_class_slots.insert(className, slot);
+			return slot;
+		}
+
+		QIcon ClassIconTable::iconFor(QString className){
+			int slot = slotFor(className);
+			if(slot < 0){
+				return QIcon();
+			}
+			return ob_studio_slot_icons[slot];
+		}
+
+		QPixmap ClassIconTable::getAtlas(){
+			return ob_studio_icon_atlas;
+		}
+
+		QRect ClassIconTable::rectFor(QString className){
+			int slot = slotFor(className);
+			if(slot < 0){
+				return QRect();
+			}
+			return ob_studio_slot_rects[slot];
+		}
+	}
+}
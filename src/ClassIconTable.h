@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OB_STUDIO_CLASSICONTABLE_H_
+#define OB_STUDIO_CLASSICONTABLE_H_
+
+#include <QString>
+#include <QIcon>
+#include <QPixmap>
+#include <QRect>
+
+#define OB_STUDIO_CLASS_ICON_SIZE 16
+
+namespace OB{
+	namespace Studio{
+		/*
+		 * Which icon every class gets, worked out once after the
+		 * classes are registered. A class without its own icon uses
+		 * its nearest ancestor's.
+		 *
+		 * Each distinct icon is loaded once and packed into a single
+		 * atlas, and every class shares the icon cut from its cell,
+		 * so filling the explorer does no resource lookups.
+		 */
+		class ClassIconTable{
+		public:
+			// Call once every class is registered
+			static void build();
+
+			static QIcon iconFor(QString className);
+
+			static QPixmap getAtlas();
+			// Empty if className's icon isn't in the atlas
+			static QRect rectFor(QString className);
+
+		private:
+			static int slotFor(QString className);
+		};
+	}
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// End:
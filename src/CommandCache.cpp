@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CommandCache.h"
+
+#include <QCryptographicHash>
+#include <QVariantMap>
+
+#include <openblox.h>
+
+namespace OB{
+	namespace Studio{
+		static int ob_studio_chunk_writer(lua_State* L, const void* p, size_t sz, void* ud){
+			((QByteArray*)ud)->append((const char*)p, sz);
+			return 0;
+		}
+
+		CommandCache::CommandCache(){
+			maxEntries = OB_STUDIO_DEFAULT_COMMAND_CACHE_SIZE;
+			hits = 0;
+			misses = 0;
+		}
+
+		CommandCache::~CommandCache(){}
+
+		static QByteArray ob_studio_chunk_digest(const QByteArray& key, const QByteArray& bytecode){
+			QCryptographicHash digest(QCryptographicHash::Sha1);
+			digest.addData(key);
+			digest.addData(bytecode);
+			return digest.result();
+		}
+
+		int CommandCache::load(lua_State* L, QString code, bool* hit){
+			QByteArray src = code.toUtf8();
+			QByteArray key = QCryptographicHash::hash(src, QCryptographicHash::Sha1);
+
+			auto it = chunks.find(key);
+			if(it != chunks.end()){
+				// The chunk name was saved with the bytecode
+				if(luaL_loadbufferx(L, it->constData(), it->size(), src.constData(), "b") == LUA_OK){
+					hits++;
+					if(hit){
+						*hit = true;
+					}
+					touch(key);
+					return LUA_OK;
+				}
+
+				// Not something this Lua can use after all
+				lua_pop(L, 1);
+				chunks.erase(it);
+				order.removeAll(key);
+			}
+
+			misses++;
+			if(hit){
+				*hit = false;
+			}
+
+			int s = luaL_loadstring(L, src.constData());
+			if(s == LUA_OK){
+				QByteArray bytecode;
+				if(lua_dump(L, ob_studio_chunk_writer, &bytecode, 0) == 0){
+					chunks.insert(key, bytecode);
+					touch(key);
+					trim();
+				}
+			}
+			return s;
+		}
+
+		int CommandCache::getHits(){
+			return hits;
+		}
+
+		int CommandCache::getMisses(){
+			return misses;
+		}
+
+		void CommandCache::setMaxEntries(int maxEntries){
+			this->maxEntries = qMax(0, maxEntries);
+			trim();
+		}
+
+		void CommandCache::clear(){
+			chunks.clear();
+			order.clear();
+		}
+
+		void CommandCache::touch(const QByteArray& key){
+			order.removeOne(key);
+			order.append(key);
+		}
+
+		void CommandCache::trim(){
+			while(order.size() > maxEntries){
+				chunks.remove(order.takeFirst());
+			}
+		}
+
+		void CommandCache::readSettings(QSettings* settings){
+			if(settings->value("bytecode_version").toInt() != LUA_VERSION_NUM){
+				return;
+			}
+
+			clear();
+
+			// Stored oldest first
+			QList<QVariant> stored = settings->value("bytecode").toList();
+			for(int i = 0; i < stored.size(); i++){
+				QVariantMap entry = stored[i].toMap();
+				QByteArray key = QByteArray::fromHex(entry.value("hash").toByteArray());
+				QByteArray bytecode = entry.value("chunk").toByteArray();
+				QByteArray digest = QByteArray::fromHex(entry.value("digest").toByteArray());
+
+				// A damaged or edited chunk would crash the VM
+				if(!key.isEmpty() && !bytecode.isEmpty() && digest == ob_studio_chunk_digest(key, bytecode)){
+					chunks.insert(key, bytecode);
+					touch(key);
+				}
+			}
+
+			trim();
+		}
+
+		void CommandCache::writeSettings(QSettings* settings){
+			QList<QVariant> stored;
+			for(int i = 0; i < order.size(); i++){
+				QVariantMap entry;
+				entry.insert("hash", order[i].toHex());
+				entry.insert("chunk", chunks.value(order[i]));
+				entry.insert("digest", ob_studio_chunk_digest(order[i], chunks.value(order[i])).toHex());
+				stored.append(entry);
+			}
+
+			settings->setValue("bytecode_version", LUA_VERSION_NUM);
+			settings->setValue("bytecode", stored);
+		}
+	}
+}
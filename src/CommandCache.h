@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OB_STUDIO_COMMANDCACHE_H_
+#define OB_STUDIO_COMMANDCACHE_H_
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QSettings>
+
+#include <OBEngine.h>
+
+#define OB_STUDIO_DEFAULT_COMMAND_CACHE_SIZE 50
+
+namespace OB{
+	namespace Studio{
+		/*
+		 * Compiled command bar chunks, keyed by a SHA-1 of their
+		 * source. A hit loads the bytecode instead of parsing the
+		 * source again. The least recently run chunk is dropped once
+		 * there are more than maxEntries.
+		 *
+		 * Bytecode is only good for the Lua version that made it, so
+		 * the cache is persisted along with that version and thrown
+		 * out if it doesn't match. Lua doesn't check bytecode before
+		 * running it, so each persisted chunk also carries a digest
+		 * of itself and its key, and any that doesn't match is
+		 * dropped rather than loaded.
+		 */
+		class CommandCache{
+		public:
+			CommandCache();
+			virtual ~CommandCache();
+
+			// Same contract as luaL_loadstring, hit says whether the
+			// chunk came from the cache
+			int load(lua_State* L, QString code, bool* hit = NULL);
+
+			int getHits();
+			int getMisses();
+
+			void setMaxEntries(int maxEntries);
+			void clear();
+
+			// Within whatever settings group the caller has open
+			void readSettings(QSettings* settings);
+			void writeSettings(QSettings* settings);
+
+		private:
+			void touch(const QByteArray& key);
+			void trim();
+
+			QHash<QByteArray, QByteArray> chunks;
+			QList<QByteArray> order;
+			int maxEntries;
+
+			int hits;
+			int misses;
+		};
+	}
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// End:
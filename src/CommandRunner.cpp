@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CommandRunner.h"
+
+#include <openblox.h>
+
+namespace OB{
+	namespace Studio{
+		// Only the GUI thread runs commands. Threads resumed elsewhere
+		// can inherit the hook but never see a runner here.
+		static thread_local CommandRunner* ob_studio_cur_command = NULL;
+
+		CommandRunner::CommandRunner(OBEngine* eng){
+			this->eng = eng;
+			L = NULL;
+			sliceNs = 0;
+			sliceYielded = false;
+		}
+
+		CommandRunner::~CommandRunner(){
+			stop();
+		}
+
+		bool CommandRunner::start(QString code, CommandCache* cache, bool* cacheHit){
+			if(L || !eng){
+				return false;
+			}
+
+			lua_State* gL = eng->getGlobalLuaState();
+			if(!gL){
+				// Prevents segfaults when commands are run before initialization
+				return false;
+			}
+
+			L = Lua::initThread(gL);
+			Lua::setGetsPaused(L, false);
+			Lua::setDMBound(L, false);
+
+			int s;
+			if(cache){
+				s = cache->load(L, code, cacheHit);
+			}else{
+				s = luaL_loadstring(L, code.toStdString().c_str());
+			}
+			if(s != 0){
+				Lua::handle_errors(L);
+				Lua::close_state(L);
+				L = NULL;
+				return false;
+			}
+
+			lua_sethook(L, &CommandRunner::hook, LUA_MASKCOUNT, OB_STUDIO_COMMAND_HOOK_COUNT);
+			return true;
+		}
+
+		bool CommandRunner::isRunning(){
+			return L != NULL;
+		}
+
+		bool CommandRunner::step(int sliceMs){
+			if(!L){
+				return false;
+			}
+
+			sliceNs = (qint64)sliceMs * 1000000;
+			sliceYielded = false;
+			slice.start();
+
+			ob_studio_cur_command = this;
+			int s = lua_resume(L, NULL, 0);
+			ob_studio_cur_command = NULL;
+
+			if(s == LUA_YIELD && sliceYielded){
+				// Out of time, more next frame
+				return false;
+			}
+
+			// Done with it, or it yielded itself and belongs to the
+			// engine now
+			lua_sethook(L, NULL, 0, 0);
+
+			if(s != LUA_OK && s != LUA_YIELD){
+				Lua::handle_errors(L);
+				Lua::close_state(L);
+			}
+			if(s == LUA_OK){
+				Lua::close_state(L);
+			}
+
+			L = NULL;
+			return true;
+		}
+
+		void CommandRunner::stop(){
+			if(!L){
+				return;
+			}
+
+			lua_sethook(L, NULL, 0, 0);
+			Lua::close_state(L);
+			L = NULL;
+		}
+
+		void CommandRunner::hook(lua_State* L, lua_Debug* ar){
+			CommandRunner* runner = ob_studio_cur_command;
+
+			// Only the command's own thread is yielded, a coroutine it
+			// resumed would just hand the yield back to the script
+			if(!runner || runner->L != L){
+				return;
+			}
+
+			if(runner->slice.nsecsElapsed() >= runner->sliceNs && lua_isyieldable(L)){
+				runner->sliceYielded = true;
+				lua_yield(L, 0);
+			}
+		}
+	}
+}
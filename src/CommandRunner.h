@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OB_STUDIO_COMMANDRUNNER_H_
+#define OB_STUDIO_COMMANDRUNNER_H_
+
+#include <QString>
+#include <QElapsedTimer>
+
+#include <OBEngine.h>
+
+#include "CommandCache.h"
+
+#define OB_STUDIO_DEFAULT_COMMAND_SLICE 8
+#define OB_STUDIO_COMMAND_HOOK_COUNT 1000
+
+namespace OB{
+	namespace Studio{
+		/*
+		 * Runs a command bar script a time slice at a time. A count
+		 * hook checks the clock every OB_STUDIO_COMMAND_HOOK_COUNT
+		 * instructions and yields the script once its slice is up, so
+		 * a long loop is spread over as many frames as it needs and
+		 * can be stopped between them.
+		 *
+		 * If the script yields on its own, wait() for example, it's
+		 * left to the engine like any other script.
+		 *
+		 * Everything here happens on the GUI thread with the engine
+		 * held.
+		 */
+		class CommandRunner{
+		public:
+			CommandRunner(OBEngine* eng);
+			virtual ~CommandRunner();
+
+			// Compiles, through cache if there is one, without running
+			// anything, step() runs the first slice. cacheHit says
+			// whether the cache had it, and is left alone if there's
+			// no cache. False if there's already a command running or
+			// it didn't compile.
+			bool start(QString code, CommandCache* cache = NULL, bool* cacheHit = NULL);
+			bool isRunning();
+
+			// Returns true once the command is done
+			bool step(int sliceMs);
+			void stop();
+
+		private:
+			static void hook(lua_State* L, lua_Debug* ar);
+
+			OBEngine* eng;
+			lua_State* L;
+
+			QElapsedTimer slice;
+			qint64 sliceNs;
+			bool sliceYielded;
+		};
+	}
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// End:
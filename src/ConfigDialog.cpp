@@ -41,6 +41,7 @@ namespace OB{
 			pagesWidget = new QStackedWidget();
 			pagesWidget->addWidget(new GeneralConfigPage(this));
 			pagesWidget->addWidget(new OutputConfigPage(this));
+			pagesWidget->addWidget(new PerformanceConfigPage(this));
 
 			QPushButton* closeButton = new QPushButton("Close");
 			applyButton = new QPushButton("Apply");
@@ -89,6 +90,11 @@ namespace OB{
 			outputConfig->setTextAlignment(Qt::AlignHCenter);
 			outputConfig->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled);
 
+			QListWidgetItem* performanceConfig = new QListWidgetItem(contentsWidget);
+			performanceConfig->setText("Performance");
+			performanceConfig->setTextAlignment(Qt::AlignHCenter);
+			performanceConfig->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled);
+
 			connect(contentsWidget, &QListWidget::currentItemChanged, this, &ConfigDialog::changePage);
 		}
 
@@ -107,5 +107,111 @@ namespace OB{
 				}
 			}
 		}
+
+		PerformanceConfigPage::PerformanceConfigPage(ConfigDialog* dia) : ConfigPage(dia){
+			QVBoxLayout* mainLayout = new QVBoxLayout();
+
+			QLabel* tickRateLabel = new QLabel("Simulation rate (ticks per second)");
+			mainLayout->addWidget(tickRateLabel);
+
+			opt_tickRate = new QSpinBox();
+			opt_tickRate->setMinimum(1);
+			opt_tickRate->setMaximum(OB_STUDIO_MAX_FRAME_RATE);
+			mainLayout->addWidget(opt_tickRate);
+
+			QLabel* renderRateLabel = new QLabel("Render rate (frames per second)");
+			mainLayout->addWidget(renderRateLabel);
+
+			opt_renderRate = new QSpinBox();
+			opt_renderRate->setMinimum(1);
+			opt_renderRate->setMaximum(OB_STUDIO_MAX_FRAME_RATE);
+			mainLayout->addWidget(opt_renderRate);
+
+			QLabel* backgroundPolicyLabel = new QLabel("Games in background tabs");
+			mainLayout->addWidget(backgroundPolicyLabel);
+
+			opt_backgroundPolicy = new QComboBox();
+			opt_backgroundPolicy->addItem("Simulate at full rate", (int)TickPolicy::Full);
+			opt_backgroundPolicy->addItem("Simulate at reduced rate", (int)TickPolicy::Reduced);
+			opt_backgroundPolicy->addItem("Pause", (int)TickPolicy::Paused);
+			mainLayout->addWidget(opt_backgroundPolicy);
+
+			QLabel* backgroundTickRateLabel = new QLabel("Reduced simulation rate (ticks per second)");
+			mainLayout->addWidget(backgroundTickRateLabel);
+
+			opt_backgroundTickRate = new QSpinBox();
+			opt_backgroundTickRate->setMinimum(1);
+			opt_backgroundTickRate->setMaximum(OB_STUDIO_MAX_FRAME_RATE);
+			mainLayout->addWidget(opt_backgroundTickRate);
+
+			opt_idleMode = new QCheckBox("Stop rendering and slow down ticking while idle");
+			mainLayout->addWidget(opt_idleMode);
+
+			QLabel* idleTimeoutLabel = new QLabel("Go idle after no input for (seconds)");
+			mainLayout->addWidget(idleTimeoutLabel);
+
+			opt_idleTimeout = new QSpinBox();
+			opt_idleTimeout->setMinimum(1);
+			opt_idleTimeout->setMaximum(3600);
+			mainLayout->addWidget(opt_idleTimeout);
+
+			opt_threadedTicks = new QCheckBox("Simulate each game on its own thread");
+			mainLayout->addWidget(opt_threadedTicks);
+
+			StudioWindow* win = StudioWindow::static_win;
+			if(win){
+				if(win->scheduler){
+					opt_tickRate->setValue(win->scheduler->getTickRate());
+					opt_renderRate->setValue(win->scheduler->getRenderRate());
+					opt_idleMode->setChecked(win->scheduler->isIdleEnabled());
+					opt_idleTimeout->setValue(win->scheduler->getIdleTimeout() / 1000);
+					opt_threadedTicks->setChecked(win->scheduler->isThreadedTicks());
+					opt_backgroundPolicy->setCurrentIndex(opt_backgroundPolicy->findData((int)win->scheduler->getBackgroundPolicy()));
+					opt_backgroundTickRate->setValue(win->scheduler->getBackgroundTickRate());
+				}
+			}
+
+			if(dia){
+				connect(opt_tickRate, static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged), dia, &ConfigDialog::optionChanged);
+				connect(opt_renderRate, static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged), dia, &ConfigDialog::optionChanged);
+				connect(opt_idleMode, &QCheckBox::stateChanged, dia, &ConfigDialog::optionChanged);
+				connect(opt_idleTimeout, static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged), dia, &ConfigDialog::optionChanged);
+				connect(opt_threadedTicks, &QCheckBox::stateChanged, dia, &ConfigDialog::optionChanged);
+				connect(opt_backgroundPolicy, static_cast<void(QComboBox::*)(int)>(&QComboBox::currentIndexChanged), dia, &ConfigDialog::optionChanged);
+				connect(opt_backgroundTickRate, static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged), dia, &ConfigDialog::optionChanged);
+			}
+
+			setLayout(mainLayout);
+		}
+
+		void PerformanceConfigPage::saveChanges(){
+			StudioWindow* win = StudioWindow::static_win;
+			if(win){
+				if(win->scheduler){
+					win->scheduler->setTickRate(opt_tickRate->value());
+					win->scheduler->setRenderRate(opt_renderRate->value());
+					win->scheduler->setIdleEnabled(opt_idleMode->isChecked());
+					win->scheduler->setIdleTimeout(opt_idleTimeout->value() * 1000);
+					win->scheduler->setThreadedTicks(opt_threadedTicks->isChecked());
+					win->scheduler->setBackgroundPolicy((TickPolicy)opt_backgroundPolicy->currentData().toInt());
+					win->scheduler->setBackgroundTickRate(opt_backgroundTickRate->value());
+				}
+				if(win->settingsInst){
+					QSettings* settings = win->settingsInst;
+					settings->beginGroup("scheduler");
+					{
+						settings->setValue("tick_rate", opt_tickRate->value());
+						settings->setValue("render_rate", opt_renderRate->value());
+						settings->setValue("idle_mode", opt_idleMode->isChecked());
+						settings->setValue("idle_timeout", opt_idleTimeout->value() * 1000);
+						settings->setValue("threaded_ticks", opt_threadedTicks->isChecked());
+						settings->setValue("background_policy", opt_backgroundPolicy->currentData().toInt());
+						settings->setValue("background_tick_rate", opt_backgroundTickRate->value());
+					}
+					settings->endGroup();
+					settings->sync();
+				}
+			}
+		}
 	}
 }
@@ -22,6 +22,7 @@
 
 #include <QCheckBox>
 #include <QSpinBox>
+#include <QComboBox>
 
 namespace OB{
 	namespace Studio{
@@ -58,6 +59,22 @@ namespace OB{
 		private:
 			QSpinBox* opt_history;
 		};
+
+		class PerformanceConfigPage: public ConfigPage{
+		public:
+			PerformanceConfigPage(ConfigDialog* dia);
+
+			virtual void saveChanges();
+
+		private:
+			QSpinBox* opt_tickRate;
+			QSpinBox* opt_renderRate;
+			QCheckBox* opt_idleMode;
+			QSpinBox* opt_idleTimeout;
+			QCheckBox* opt_threadedTicks;
+			QComboBox* opt_backgroundPolicy;
+			QSpinBox* opt_backgroundTickRate;
+		};
 	}
 }
 
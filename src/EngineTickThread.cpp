@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "EngineTickThread.h"
+
+#include "FrameScheduler.h"
+
+#include <QElapsedTimer>
+
+namespace OB{
+	namespace Studio{
+		EngineTickThread::EngineTickThread(OBEngine* eng, QMutex* engineLock) : QThread(NULL){
+			this->eng = eng;
+			this->engineLock = engineLock;
+
+			tickRate = OB_STUDIO_DEFAULT_TICK_RATE;
+			paused = false;
+			stopRequested = false;
+		}
+
+		EngineTickThread::~EngineTickThread(){
+			requestStop();
+			wait();
+		}
+
+		void EngineTickThread::setTickRate(int tickRate){
+			if(tickRate < 1){
+				tickRate = 1;
+			}
+			this->tickRate = tickRate;
+
+			sleepCond.wakeAll();
+		}
+
+		int EngineTickThread::getTickRate(){
+			return tickRate;
+		}
+
+		void EngineTickThread::setPaused(bool paused){
+			this->paused = paused;
+
+			sleepLock.lock();
+			sleepCond.wakeAll();
+			sleepLock.unlock();
+		}
+
+		bool EngineTickThread::isPaused(){
+			return paused;
+		}
+
+		void EngineTickThread::requestStop(){
+			stopRequested = true;
+
+			sleepLock.lock();
+			sleepCond.wakeAll();
+			sleepLock.unlock();
+		}
+
+		void EngineTickThread::run(){
+			QElapsedTimer clock;
+			clock.start();
+
+			qint64 nextTickAt = 0;
+
+			while(!stopRequested){
+				if(paused){
+					sleepLock.lock();
+					while(paused && !stopRequested){
+						sleepCond.wait(&sleepLock);
+					}
+					sleepLock.unlock();
+
+					nextTickAt = clock.nsecsElapsed();
+					continue;
+				}
+
+				engineLock->lock();
+				eng->tick();
+				engineLock->unlock();
+
+				qint64 tickInterval = 1000000000LL / tickRate;
+				nextTickAt += tickInterval;
+
+				qint64 now = clock.nsecsElapsed();
+				if(nextTickAt < now){
+					// We fell behind, don't try to catch up with a burst,
+					// and give the GUI thread a chance at the engine lock
+					nextTickAt = now;
+					yieldCurrentThread();
+					continue;
+				}
+
+				sleepLock.lock();
+				if(!stopRequested){
+					sleepCond.wait(&sleepLock, (nextTickAt - now) / 1000000);
+				}
+				sleepLock.unlock();
+			}
+		}
+	}
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OB_STUDIO_ENGINETICKTHREAD_H_
+#define OB_STUDIO_ENGINETICKTHREAD_H_
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <OBEngine.h>
+
+#include <atomic>
+
+namespace OB{
+	namespace Studio{
+		/*
+		 * Ticks a single engine at a fixed rate off the GUI thread.
+		 * Every tick is done while holding engineLock, which the GUI
+		 * thread also takes whenever it touches the same engine.
+		 */
+		class EngineTickThread: public QThread{
+		public:
+			EngineTickThread(OBEngine* eng, QMutex* engineLock);
+			virtual ~EngineTickThread();
+
+			void setTickRate(int tickRate);
+			int getTickRate();
+
+			void setPaused(bool paused);
+			bool isPaused();
+
+			void requestStop();
+
+		protected:
+			virtual void run();
+
+		private:
+			OBEngine* eng;
+			QMutex* engineLock;
+
+			std::atomic<int> tickRate;
+			std::atomic<bool> paused;
+			std::atomic<bool> stopRequested;
+
+			QMutex sleepLock;
+			QWaitCondition sleepCond;
+		};
+	}
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// End:
@@ -17,34 +17,45 @@
  * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
  */
 
-#include "InstanceTreeItem.h"
+#include "FileWriterThread.h"
 
 namespace OB{
 	namespace Studio{
-		InstanceTreeItem::InstanceTreeItem(shared_ptr<Instance::Instance> inst, QTreeWidget* parent) : QTreeWidgetItem(parent){
-			this->inst = inst;
-
-			this->setText(0, QString(inst->getName().c_str()));
-
-			setChildIndicatorPolicy(QTreeWidgetItem::DontShowIndicatorWhenChildless);
-
-			updateFlags();
+		FileWriterThread::FileWriterThread() : QThread(NULL){
+			stopRequested = false;
 		}
 
-		InstanceTreeItem::~InstanceTreeItem(){}
+		FileWriterThread::~FileWriterThread(){}
 
-		void InstanceTreeItem::updateFlags(){
-			Qt::ItemFlags flags = Qt::ItemIsSelectable | Qt::ItemIsEditable | Qt::ItemIsDropEnabled | Qt::ItemIsEnabled;
+		void FileWriterThread::post(std::function<void()> job){
+			jobs.push(job);
 
-			if(!inst->ParentLocked){
-				flags = flags | Qt::ItemIsDragEnabled;
-			}
+			sleepLock.lock();
+			sleepCond.wakeAll();
+			sleepLock.unlock();
+		}
 
-			setFlags(flags);
+		void FileWriterThread::requestStop(){
+			sleepLock.lock();
+			stopRequested = true;
+			sleepCond.wakeAll();
+			sleepLock.unlock();
 		}
 
-		shared_ptr<Instance::Instance> InstanceTreeItem::GetInstance(){
-			return inst;
+		void FileWriterThread::run(){
+			while(true){
+				jobs.drain();
+
+				sleepLock.lock();
+				if(jobs.isEmpty()){
+					if(stopRequested){
+						sleepLock.unlock();
+						break;
+					}
+					sleepCond.wait(&sleepLock);
+				}
+				sleepLock.unlock();
+			}
 		}
 	}
 }
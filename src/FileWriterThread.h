@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OB_STUDIO_FILEWRITERTHREAD_H_
+#define OB_STUDIO_FILEWRITERTHREAD_H_
+
+#include "UiTaskQueue.h"
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <functional>
+
+namespace OB{
+	namespace Studio{
+		/*
+		 * Runs file jobs on one thread, in the order they were
+		 * posted. Any thread may post, nothing waits on the disk
+		 * except requestStop() followed by wait(), which lets every
+		 * job already posted finish first.
+		 */
+		class FileWriterThread: public QThread{
+		public:
+			FileWriterThread();
+			virtual ~FileWriterThread();
+
+			void post(std::function<void()> job);
+			void requestStop();
+
+		protected:
+			virtual void run();
+
+		private:
+			UiTaskQueue jobs;
+
+			bool stopRequested;
+			QMutex sleepLock;
+			QWaitCondition sleepCond;
+		};
+	}
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,451 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "FrameScheduler.h"
+
+#include "StudioWindow.h"
+
+#include <QApplication>
+#include <QAbstractEventDispatcher>
+#include <QScreen>
+#include <QEvent>
+
+// Weight given to the newest sample in the moving averages
+#define OB_STUDIO_STATS_SMOOTHING 0.1
+
+namespace OB{
+	namespace Studio{
+		static double ob_studio_smooth(double avg, double sample){
+			if(avg <= 0){
+				return sample;
+			}
+			return avg + (sample - avg) * OB_STUDIO_STATS_SMOOTHING;
+		}
+
+		static int ob_studio_clamp_rate(int rate){
+			if(rate < 1){
+				return 1;
+			}
+			if(rate > OB_STUDIO_MAX_FRAME_RATE){
+				return OB_STUDIO_MAX_FRAME_RATE;
+			}
+			return rate;
+		}
+
+		/*
+		 * QTimer only does whole milliseconds, so the deadline is
+		 * kept in nanoseconds and moved on by the exact period each
+		 * time. A timer that fell behind fires right away rather than
+		 * bursting to catch up.
+		 */
+		static void ob_studio_arm_timer(QTimer* timer, qint64& deadline, qint64 now, int rate){
+			deadline += 1000000000LL / rate;
+			if(deadline < now){
+				deadline = now;
+			}
+
+			timer->start((int)((deadline - now + 999999) / 1000000));
+		}
+
+		FrameScheduler::FrameScheduler(StudioWindow* win) : QObject(win){
+			this->win = win;
+
+			tickRate = OB_STUDIO_DEFAULT_TICK_RATE;
+			renderRate = OB_STUDIO_DEFAULT_RENDER_RATE;
+			backgroundTickRate = OB_STUDIO_DEFAULT_BACKGROUND_TICK_RATE;
+			idleTimeout = OB_STUDIO_DEFAULT_IDLE_TIMEOUT;
+
+			backgroundPolicy = TickPolicy::Reduced;
+
+			// Render at the display's refresh rate unless told otherwise
+			QScreen* screen = QGuiApplication::primaryScreen();
+			if(screen){
+				int refreshRate = qRound(screen->refreshRate());
+				if(refreshRate > 0){
+					renderRate = ob_studio_clamp_rate(refreshRate);
+				}
+			}
+
+			running = false;
+			idle = false;
+			idleEnabled = true;
+			threadedTicks = false;
+
+			lastFrameAt = -1;
+			idleSince = -1;
+			lastActivityAt = 0;
+			pendingInputAt = -1;
+
+			nextTickAt = 0;
+			nextRenderAt = 0;
+
+			resetStats();
+
+			tickTimer = new QTimer(this);
+			tickTimer->setTimerType(Qt::PreciseTimer);
+			tickTimer->setSingleShot(true);
+			connect(tickTimer, &QTimer::timeout, this, &FrameScheduler::tick);
+
+			renderTimer = new QTimer(this);
+			renderTimer->setTimerType(Qt::PreciseTimer);
+			renderTimer->setSingleShot(true);
+			connect(renderTimer, &QTimer::timeout, this, &FrameScheduler::render);
+
+			clock.start();
+
+			qApp->installEventFilter(this);
+
+			QAbstractEventDispatcher* dispatcher = QAbstractEventDispatcher::instance();
+			if(dispatcher){
+				connect(dispatcher, &QAbstractEventDispatcher::awake, this, &FrameScheduler::acquireEngine);
+				connect(dispatcher, &QAbstractEventDispatcher::aboutToBlock, this, &FrameScheduler::releaseEngine);
+			}
+		}
+
+		FrameScheduler::~FrameScheduler(){
+			qApp->removeEventFilter(this);
+		}
+
+		void FrameScheduler::loadSettings(QSettings* settings){
+			if(!settings){
+				return;
+			}
+
+			settings->beginGroup("scheduler");
+			{
+				if(settings->contains("tick_rate")){
+					setTickRate(settings->value("tick_rate").toInt());
+				}
+				if(settings->contains("render_rate")){
+					setRenderRate(settings->value("render_rate").toInt());
+				}
+				if(settings->contains("idle_mode")){
+					setIdleEnabled(settings->value("idle_mode").toBool());
+				}
+				if(settings->contains("idle_timeout")){
+					setIdleTimeout(settings->value("idle_timeout").toInt());
+				}
+				if(settings->contains("threaded_ticks")){
+					setThreadedTicks(settings->value("threaded_ticks").toBool());
+				}
+				if(settings->contains("background_policy")){
+					setBackgroundPolicy((TickPolicy)settings->value("background_policy").toInt());
+				}
+				if(settings->contains("background_tick_rate")){
+					setBackgroundTickRate(settings->value("background_tick_rate").toInt());
+				}
+			}
+			settings->endGroup();
+		}
+
+		void FrameScheduler::start(){
+			running = true;
+			idle = false;
+			lastActivityAt = clock.elapsed();
+
+			nextTickAt = nextRenderAt = clock.nsecsElapsed();
+			scheduleTick();
+			scheduleRender();
+		}
+
+		void FrameScheduler::stop(){
+			running = false;
+
+			tickTimer->stop();
+			renderTimer->stop();
+		}
+
+		void FrameScheduler::wake(){
+			lastActivityAt = clock.elapsed();
+
+			if(idle){
+				leaveIdle();
+			}
+		}
+
+		bool FrameScheduler::isIdle(){
+			return idle;
+		}
+
+		int FrameScheduler::getTickRate(){
+			return tickRate;
+		}
+
+		void FrameScheduler::setTickRate(int tickRate){
+			this->tickRate = ob_studio_clamp_rate(tickRate);
+
+			if(tickTimer->isActive() && !idle){
+				nextTickAt = clock.nsecsElapsed();
+				scheduleTick();
+			}
+
+			if(threadedTicks){
+				win->updateTickThreads();
+			}
+		}
+
+		int FrameScheduler::getRenderRate(){
+			return renderRate;
+		}
+
+		void FrameScheduler::setRenderRate(int renderRate){
+			this->renderRate = ob_studio_clamp_rate(renderRate);
+
+			if(renderTimer->isActive()){
+				nextRenderAt = clock.nsecsElapsed();
+				scheduleRender();
+			}
+		}
+
+		bool FrameScheduler::isIdleEnabled(){
+			return idleEnabled;
+		}
+
+		void FrameScheduler::setIdleEnabled(bool idleEnabled){
+			this->idleEnabled = idleEnabled;
+
+			if(!idleEnabled){
+				wake();
+			}
+		}
+
+		int FrameScheduler::getIdleTimeout(){
+			return idleTimeout;
+		}
+
+		void FrameScheduler::setIdleTimeout(int idleTimeout){
+			this->idleTimeout = qMax(0, idleTimeout);
+		}
+
+		bool FrameScheduler::isThreadedTicks(){
+			return threadedTicks;
+		}
+
+		void FrameScheduler::setThreadedTicks(bool threadedTicks){
+			if(this->threadedTicks != threadedTicks){
+				this->threadedTicks = threadedTicks;
+				win->updateTickThreads();
+			}
+		}
+
+		TickPolicy FrameScheduler::getBackgroundPolicy(){
+			return backgroundPolicy;
+		}
+
+		void FrameScheduler::setBackgroundPolicy(TickPolicy backgroundPolicy){
+			// Default only makes sense per tab
+			if(backgroundPolicy == TickPolicy::Default){
+				backgroundPolicy = TickPolicy::Reduced;
+			}
+			this->backgroundPolicy = backgroundPolicy;
+
+			win->updateTickThreads();
+		}
+
+		int FrameScheduler::getBackgroundTickRate(){
+			return backgroundTickRate;
+		}
+
+		void FrameScheduler::setBackgroundTickRate(int backgroundTickRate){
+			this->backgroundTickRate = ob_studio_clamp_rate(backgroundTickRate);
+
+			win->updateTickThreads();
+		}
+
+		FrameStats FrameScheduler::getStats(){
+			FrameStats curStats = stats;
+			if(idle && idleSince >= 0){
+				curStats.idleTime += clock.elapsed() - idleSince;
+			}
+			return curStats;
+		}
+
+		void FrameScheduler::resetStats(){
+			stats.ticks = 0;
+			stats.frames = 0;
+			stats.tickTime = 0;
+			stats.renderTime = 0;
+			stats.frameInterval = 0;
+			stats.inputLatency = 0;
+			stats.idleTime = 0;
+		}
+
+		bool FrameScheduler::eventFilter(QObject* obj, QEvent* evt){
+			switch(evt->type()){
+				case QEvent::MouseButtonPress:
+				case QEvent::MouseButtonRelease:
+				case QEvent::MouseButtonDblClick:
+				case QEvent::MouseMove:
+				case QEvent::Wheel:
+				case QEvent::KeyPress:
+				case QEvent::KeyRelease:
+				case QEvent::TouchBegin: {
+					// Only the first input since the last frame counts
+					// toward latency, that's the one the user waits on
+					if(pendingInputAt < 0){
+						pendingInputAt = clock.nsecsElapsed();
+					}
+					wake();
+					break;
+				}
+				default: {
+					break;
+				}
+			}
+
+			return QObject::eventFilter(obj, evt);
+		}
+
+		void FrameScheduler::tick(){
+			qint64 tickStart = clock.nsecsElapsed();
+
+			// Anything printed or changed means a script is doing
+			// something worth watching
+			if(win->tickEngines()){
+				wake();
+			}
+
+			if(!idle){
+				stats.ticks++;
+				stats.tickTime = ob_studio_smooth(stats.tickTime, (clock.nsecsElapsed() - tickStart) / 1000000.0);
+
+				updateIdle();
+			}
+
+			// Waking up already rearmed it
+			if(!tickTimer->isActive()){
+				scheduleTick();
+			}
+		}
+
+		void FrameScheduler::render(){
+			if(idle){
+				return;
+			}
+
+			scheduleRender();
+
+			// Nobody can see a minimized window
+			if(win->isMinimized() || !win->isVisible()){
+				return;
+			}
+
+			qint64 renderStart = clock.nsecsElapsed();
+
+			win->renderEngines();
+
+			qint64 renderEnd = clock.nsecsElapsed();
+
+			stats.frames++;
+			stats.renderTime = ob_studio_smooth(stats.renderTime, (renderEnd - renderStart) / 1000000.0);
+
+			if(lastFrameAt >= 0){
+				stats.frameInterval = ob_studio_smooth(stats.frameInterval, (renderEnd - lastFrameAt) / 1000000.0);
+			}
+			lastFrameAt = renderEnd;
+
+			if(pendingInputAt >= 0){
+				stats.inputLatency = ob_studio_smooth(stats.inputLatency, (renderEnd - pendingInputAt) / 1000000.0);
+				pendingInputAt = -1;
+			}
+		}
+
+		void FrameScheduler::updateIdle(){
+			if(!idleEnabled || idle){
+				return;
+			}
+
+			// Nothing to simulate or draw without an open game
+			if(win->tabWidget->count() == 0){
+				enterIdle();
+				return;
+			}
+
+			// Loads, saves and commands are still going even if nobody
+			// is touching anything
+			if(win->hasActiveWork()){
+				lastActivityAt = clock.elapsed();
+				return;
+			}
+
+			if(clock.elapsed() - lastActivityAt >= idleTimeout){
+				enterIdle();
+			}
+		}
+
+		void FrameScheduler::scheduleTick(){
+			if(!running){
+				return;
+			}
+
+			if(idle){
+				if(win->tabWidget->count() == 0){
+					return;
+				}
+				ob_studio_arm_timer(tickTimer, nextTickAt, clock.nsecsElapsed(), OB_STUDIO_IDLE_TICK_RATE);
+			}else{
+				ob_studio_arm_timer(tickTimer, nextTickAt, clock.nsecsElapsed(), tickRate);
+			}
+		}
+
+		void FrameScheduler::scheduleRender(){
+			if(!running || idle){
+				return;
+			}
+			ob_studio_arm_timer(renderTimer, nextRenderAt, clock.nsecsElapsed(), renderRate);
+		}
+
+		void FrameScheduler::acquireEngine(){
+			StudioGLWidget* gW = dynamic_cast<StudioGLWidget*>(win->curTab);
+			if(gW){
+				gW->acquireEngine();
+			}
+		}
+
+		void FrameScheduler::releaseEngine(){
+			StudioGLWidget* gW = dynamic_cast<StudioGLWidget*>(win->curTab);
+			if(gW){
+				gW->unlockEngine();
+			}
+		}
+
+		void FrameScheduler::enterIdle(){
+			idle = true;
+			idleSince = clock.elapsed();
+			lastFrameAt = -1;
+
+			tickTimer->stop();
+			renderTimer->stop();
+		}
+
+		void FrameScheduler::leaveIdle(){
+			idle = false;
+			if(idleSince >= 0){
+				stats.idleTime += clock.elapsed() - idleSince;
+				idleSince = -1;
+			}
+
+			if(running){
+				nextTickAt = nextRenderAt = clock.nsecsElapsed();
+				scheduleTick();
+				scheduleRender();
+			}
+		}
+	}
+}
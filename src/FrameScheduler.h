@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OB_STUDIO_FRAMESCHEDULER_H_
+#define OB_STUDIO_FRAMESCHEDULER_H_
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QSettings>
+
+#define OB_STUDIO_DEFAULT_TICK_RATE 60
+#define OB_STUDIO_DEFAULT_RENDER_RATE 60
+#define OB_STUDIO_MAX_FRAME_RATE 1000
+
+#define OB_STUDIO_DEFAULT_BACKGROUND_TICK_RATE 10
+
+#define OB_STUDIO_DEFAULT_IDLE_TIMEOUT 3000
+// Idle games still tick this often so waiting scripts get to run
+#define OB_STUDIO_IDLE_TICK_RATE 5
+
+namespace OB{
+	namespace Studio{
+		class StudioWindow;
+
+		/*
+		 * How a game is ticked while its tab isn't the current one.
+		 * Default defers to the scheduler's background policy.
+		 */
+		enum class TickPolicy{
+			Default,
+			Full,
+			Reduced,
+			Paused
+		};
+
+		/*
+		 * Timing counters, all times in milliseconds. Averages are
+		 * exponential moving averages, so they follow recent frames
+		 * rather than the whole session.
+		 */
+		struct FrameStats{
+			quint64 ticks;
+			quint64 frames;
+
+			double tickTime;
+			double renderTime;
+			double frameInterval;
+			double inputLatency;
+
+			quint64 idleTime;
+		};
+
+		/*
+		 * Drives engine ticks and rendering from the Qt event loop.
+		 *
+		 * Ticks and renders run on separate timers so the simulation
+		 * rate doesn't depend on how fast we can draw. Each timer is
+		 * rearmed for a deadline that advances by the exact period,
+		 * so rates that don't divide 1000 still average out right.
+		 *
+		 * After a while without input, with nothing loading, saving
+		 * or running from the command bar, we go idle: rendering
+		 * stops and games only tick a few times a second. Input, or
+		 * a tick that printed or changed anything, wakes us again.
+		 * Without any open game both timers are stopped.
+		 *
+		 * In threaded mode every game ticks on its own thread and the
+		 * tick timer only drains updates those threads queued for the
+		 * GUI. The GUI thread holds the current game's engine lock
+		 * whenever it is awake, so GUI code never has to take it.
+		 */
+		class FrameScheduler: public QObject{
+		public:
+			FrameScheduler(StudioWindow* win);
+			virtual ~FrameScheduler();
+
+			void loadSettings(QSettings* settings);
+
+			void start();
+			void stop();
+			void wake();
+
+			bool isIdle();
+
+			int getTickRate();
+			void setTickRate(int tickRate);
+
+			int getRenderRate();
+			void setRenderRate(int renderRate);
+
+			bool isIdleEnabled();
+			void setIdleEnabled(bool idleEnabled);
+
+			int getIdleTimeout();
+			void setIdleTimeout(int idleTimeout);
+
+			bool isThreadedTicks();
+			void setThreadedTicks(bool threadedTicks);
+
+			TickPolicy getBackgroundPolicy();
+			void setBackgroundPolicy(TickPolicy backgroundPolicy);
+
+			int getBackgroundTickRate();
+			void setBackgroundTickRate(int backgroundTickRate);
+
+			FrameStats getStats();
+			void resetStats();
+
+			virtual bool eventFilter(QObject* obj, QEvent* evt);
+
+		private:
+			void tick();
+			void render();
+			void updateIdle();
+			void scheduleTick();
+			void scheduleRender();
+			void enterIdle();
+			void leaveIdle();
+
+			void acquireEngine();
+			void releaseEngine();
+
+			StudioWindow* win;
+
+			QTimer* tickTimer;
+			QTimer* renderTimer;
+
+			QElapsedTimer clock;
+
+			int tickRate;
+			int renderRate;
+			int backgroundTickRate;
+			int idleTimeout;
+
+			TickPolicy backgroundPolicy;
+
+			bool running;
+			bool idle;
+			bool idleEnabled;
+			bool threadedTicks;
+
+			qint64 lastFrameAt;
+			qint64 idleSince;
+			qint64 lastActivityAt;
+			qint64 pendingInputAt;
+
+			qint64 nextTickAt;
+			qint64 nextRenderAt;
+
+			FrameStats stats;
+		};
+	}
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "InstanceClipboard.h"
+
+#include "StudioGLWidget.h"
+#include "BinaryPlace.h"
+
+#include <QCoreApplication>
+#include <QEvent>
+
+#include <openblox.h>
+
+#include <unordered_set>
+
+#define OB_STUDIO_SERIALIZE_EVENT ((QEvent::Type)(QEvent::User + 1))
+
+namespace OB{
+	namespace Studio{
+		InstanceMimeData::InstanceMimeData(StudioGLWidget* source, std::vector<shared_ptr<Instance::Instance>> roots) : QMimeData(){
+			this->source = source;
+			this->roots = roots;
+			serialized = false;
+
+			if(source && source->hasTickThread()){
+				serialize();
+			}else{
+				// Posted events go out before the event loop looks at
+				// timers or input again
+				QCoreApplication::postEvent(this, new QEvent(OB_STUDIO_SERIALIZE_EVENT));
+			}
+		}
+
+		bool InstanceMimeData::event(QEvent* evt){
+			if(evt->type() == OB_STUDIO_SERIALIZE_EVENT){
+				serialize();
+				return true;
+			}
+			return QMimeData::event(evt);
+		}
+
+		InstanceMimeData::~InstanceMimeData(){}
+
+		bool InstanceMimeData::hasFormat(const QString& mimeType) const{
+			return mimeType == OB_STUDIO_INSTANCE_MIME_TYPE;
+		}
+
+		QStringList InstanceMimeData::formats() const{
+			return QStringList(OB_STUDIO_INSTANCE_MIME_TYPE);
+		}
+
+		StudioGLWidget* InstanceMimeData::getSource(){
+			return source.data();
+		}
+
+		void InstanceMimeData::detachSource(){
+			serialize();
+			source = NULL;
+		}
+
+		QVariant InstanceMimeData::retrieveData(const QString& mimeType, QVariant::Type type) const{
+			if(mimeType != OB_STUDIO_INSTANCE_MIME_TYPE){
+				return QVariant();
+			}
+
+			serialize();
+			return payload;
+		}
+
+		void InstanceMimeData::serialize() const{
+			if(serialized){
+				return;
+			}
+			serialized = true;
+
+			// The source may be ticking on its own thread
+			StudioGLWidget* src = source.data();
+			bool wasHeld = src && src->holdsEngine();
+			if(src && !wasHeld){
+				src->lockEngine();
+			}
+
+			QString error;
+			if(!BinaryPlace::saveInstances(roots, true, &payload, &error)){
+				payload.clear();
+			}
+
+			if(src && !wasHeld){
+				src->unlockEngine();
+			}
+
+			// Only the serialized copy matters now
+			roots.clear();
+		}
+
+		std::vector<shared_ptr<Instance::Instance>> InstanceMimeData::copyableRoots(const std::vector<shared_ptr<Instance::Instance>>& insts){
+			// Services can't be copied, and don't cover anything
+			// selected inside them either
+			std::vector<shared_ptr<Instance::Instance>> candidates;
+			std::unordered_set<Instance::Instance*> all;
+			for(size_t i = 0; i < insts.size(); i++){
+				if(insts[i] && ClassFactory::canCreate(insts[i]->getClassName())){
+					candidates.push_back(insts[i]);
+					all.insert(insts[i].get());
+				}
+			}
+
+			std::vector<shared_ptr<Instance::Instance>> copyable;
+			for(size_t i = 0; i < candidates.size(); i++){
+				shared_ptr<Instance::Instance> inst = candidates[i];
+
+				bool covered = false;
+				for(shared_ptr<Instance::Instance> par = inst->getParent(); par; par = par->getParent()){
+					if(all.count(par.get())){
+						covered = true;
+						break;
+					}
+				}
+
+				if(!covered){
+					copyable.push_back(inst);
+				}
+			}
+
+			return copyable;
+		}
+	}
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OB_STUDIO_INSTANCECLIPBOARD_H_
+#define OB_STUDIO_INSTANCECLIPBOARD_H_
+
+#include <QMimeData>
+#include <QPointer>
+#include <QStringList>
+
+#include <instance/Instance.h>
+
+#include <vector>
+
+#define OB_STUDIO_INSTANCE_MIME_TYPE "application/x-openblox-instances"
+
+namespace OB{
+	namespace Studio{
+		class StudioGLWidget;
+
+		/*
+		 * Copied instances on the clipboard. Copying only keeps a
+		 * reference to the copied subtrees, so the copy action itself
+		 * returns at once. They're serialized with BinaryPlace on the
+		 * next pass of the event loop, before any edit or engine tick
+		 * can reach them, or sooner if something asks for the data
+		 * first. Every paste gets that serialized copy, so a paste
+		 * is what was copied no matter what happened to the
+		 * originals since.
+		 *
+		 * A tab ticking on its own thread could change them at any
+		 * time, so those are serialized straight away.
+		 */
+		class InstanceMimeData: public QMimeData{
+		public:
+			InstanceMimeData(StudioGLWidget* source, std::vector<shared_ptr<Instance::Instance>> roots);
+			virtual ~InstanceMimeData();
+
+			virtual bool hasFormat(const QString& mimeType) const;
+			virtual QStringList formats() const;
+
+			StudioGLWidget* getSource();
+
+			// The source tab is going away, serialize while we still
+			// can and let go of its instances
+			void detachSource();
+
+			// Roots that can be copied, without anything whose
+			// ancestor is also in the list
+			static std::vector<shared_ptr<Instance::Instance>> copyableRoots(const std::vector<shared_ptr<Instance::Instance>>& insts);
+
+		protected:
+			virtual bool event(QEvent* evt);
+			virtual QVariant retrieveData(const QString& mimeType, QVariant::Type type) const;
+
+		private:
+			void serialize() const;
+
+			QPointer<StudioGLWidget> source;
+
+			mutable std::vector<shared_ptr<Instance::Instance>> roots;
+			mutable QByteArray payload;
+			mutable bool serialized;
+		};
+	}
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// End:
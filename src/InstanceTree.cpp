@@ -19,11 +19,13 @@
 
 #include "InstanceTree.h"
 
+#include "StudioGLWidget.h"
+
 #include <QtWidgets>
 
 #include <instance/Instance.h>
 
-#include "InstanceTreeItem.h"
+#include <unordered_set>
 
 namespace OB{
 	namespace Studio{
@@ -33,42 +35,54 @@ namespace OB{
 			setAcceptDrops(true);
 			setDragEnabled(true);
 			setDragDropMode(QAbstractItemView::InternalMove);
+			setEditTriggers(QAbstractItemView::EditKeyPressed | QAbstractItemView::SelectedClicked);
 			header()->close();
 
+			setUniformRowHeights(true);
 			setItemsExpandable(true);
 			setRootIsDecorated(true);
-
-			connect(this, &QTreeWidget::itemChanged, this, &InstanceTree::itemEdited);
 		}
 
 		InstanceTree::~InstanceTree(){}
 
+		InstanceTreeModel* InstanceTree::instanceModel(){
+			return dynamic_cast<InstanceTreeModel*>(model());
+		}
+
 		void InstanceTree::dropEvent(QDropEvent* evt){
-			QTreeWidgetItem* dropTarg = itemAt(evt->pos());
-			if(dropTarg){
-				QList<QTreeWidgetItem*> dragItems = selectedItems();
+			InstanceTreeModel* im = instanceModel();
+			if(!im){
+				return;
+			}
+
+			QModelIndex dropTarg = indexAt(evt->pos());
+			if(dropTarg.isValid()){
+				shared_ptr<Instance::Instance> targInst = im->instanceAt(dropTarg);
+				if(targInst){
+					std::vector<shared_ptr<Instance::Instance>> toMove;
 
-				InstanceTreeItem* targItem = dynamic_cast<InstanceTreeItem*>(dropTarg);
-				if(targItem){
-					for(int i = 0; i < dragItems.size(); i++){
-						InstanceTreeItem* srcItem = dynamic_cast<InstanceTreeItem*>(dragItems[i]);
-						if(srcItem){
-							shared_ptr<Instance::Instance> instPtr = srcItem->GetInstance();
-							if(instPtr){
-								instPtr->setParent(targItem->GetInstance(), true);
-							}
+					// Anything the target is in, or the target itself,
+					// would make a cycle
+					std::unordered_set<Instance::Instance*> targChain;
+					for(shared_ptr<Instance::Instance> cur = targInst; cur; cur = cur->getParent()){
+						targChain.insert(cur.get());
+					}
+
+					QModelIndexList dragIdxs = selectionModel()->selectedIndexes();
+					for(int i = 0; i < dragIdxs.size(); i++){
+						shared_ptr<Instance::Instance> instPtr = im->instanceAt(dragIdxs[i]);
+						if(instPtr && !instPtr->ParentLocked && targChain.count(instPtr.get()) == 0){
+							toMove.push_back(instPtr);
 						}
 					}
-				}
-			}
-		}
 
-		void InstanceTree::itemEdited(QTreeWidgetItem* item){
-			InstanceTreeItem* iti = dynamic_cast<InstanceTreeItem*>(item);
-			if(iti){
-				shared_ptr<Instance::Instance> inst = iti->GetInstance();
-				if(inst){
-					inst->setName(iti->text(0).toStdString().c_str());
+					if(toMove.empty()){
+						return;
+					}
+
+					UndoCommand* cmd = new UndoCommand("Move");
+					im->getGLWidget()->reparent(toMove, targInst, cmd);
+					im->getGLWidget()->recordUndo(cmd);
 				}
 			}
 		}
@@ -20,19 +20,20 @@
 #ifndef OB_STUDIO_INSTANCETREE_H_
 #define OB_STUDIO_INSTANCETREE_H_
 
-#include <QTreeWidgetItem>
+#include <QTreeView>
+
+#include "InstanceTreeModel.h"
 
 namespace OB{
 	namespace Studio{
-		class InstanceTree: public QTreeWidget{
+		class InstanceTree: public QTreeView{
 		public:
 			InstanceTree();
 			virtual ~InstanceTree();
 
-			virtual void dropEvent(QDropEvent* evt);
+			InstanceTreeModel* instanceModel();
 
-		public slots:
-			void itemEdited(QTreeWidgetItem* item);
+			virtual void dropEvent(QDropEvent* evt);
 		};
 	}
 }
@@ -0,0 +1,614 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "InstanceTreeModel.h"
+
+#include "StudioWindow.h"
+#include "StudioGLWidget.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace OB{
+	namespace Studio{
+		InstanceTreeModel::InstanceTreeModel(StudioGLWidget* glWidget, shared_ptr<Instance::Instance> root) : QAbstractItemModel(NULL){
+			this->glWidget = glWidget;
+			batchDepth = 0;
+
+			rootNode = createNode(root, NULL, 0);
+			populate(rootNode);
+		}
+
+		InstanceTreeModel::~InstanceTreeModel(){
+			destroyNode(rootNode);
+		}
+
+		InstanceTreeModel::Node* InstanceTreeModel::nodeAt(const QModelIndex& index) const{
+			if(!index.isValid()){
+				return rootNode;
+			}
+			return static_cast<Node*>(index.internalPointer());
+		}
+
+		InstanceTreeModel::Node* InstanceTreeModel::nodeFor(shared_ptr<Instance::Instance> inst) const{
+			if(!inst){
+				return NULL;
+			}
+
+			auto it = nodeMap.find(inst.get());
+			if(it != nodeMap.end()){
+				return it->second;
+			}
+			return NULL;
+		}
+
+		QModelIndex InstanceTreeModel::indexForNode(Node* n) const{
+			if(!n || n == rootNode){
+				return QModelIndex();
+			}
+			return createIndex(n->row, 0, n);
+		}
+
+		QModelIndex InstanceTreeModel::index(int row, int column, const QModelIndex& parent) const{
+			if(column != 0){
+				return QModelIndex();
+			}
+
+			Node* pn = nodeAt(parent);
+			if(!pn || row < 0 || row >= (int)pn->children.size()){
+				return QModelIndex();
+			}
+
+			return createIndex(row, 0, pn->children[row]);
+		}
+
+		QModelIndex InstanceTreeModel::parent(const QModelIndex& index) const{
+			if(!index.isValid()){
+				return QModelIndex();
+			}
+
+			Node* n = nodeAt(index);
+			return indexForNode(n->parent);
+		}
+
+		int InstanceTreeModel::rowCount(const QModelIndex& parent) const{
+			Node* pn = nodeAt(parent);
+			if(!pn){
+				return 0;
+			}
+			return pn->children.size();
+		}
+
+		int InstanceTreeModel::columnCount(const QModelIndex& parent) const{
+			return 1;
+		}
+
+		bool InstanceTreeModel::hasChildren(const QModelIndex& parent) const{
+			Node* pn = nodeAt(parent);
+			if(!pn){
+				return false;
+			}
+			if(pn->populated){
+				return !pn->children.empty();
+			}
+			return pn->childCount > 0;
+		}
+
+		bool InstanceTreeModel::canFetchMore(const QModelIndex& parent) const{
+			Node* pn = nodeAt(parent);
+			return pn && !pn->populated && pn->childCount > 0;
+		}
+
+		void InstanceTreeModel::fetchMore(const QModelIndex& parent){
+			Node* pn = nodeAt(parent);
+			if(pn){
+				populate(pn);
+			}
+		}
+
+		QVariant InstanceTreeModel::data(const QModelIndex& index, int role) const{
+			Node* n = nodeAt(index);
+			if(!index.isValid() || !n || !n->inst){
+				return QVariant();
+			}
+
+			switch(role){
+				case Qt::DisplayRole:
+				case Qt::EditRole: {
+					return QString(n->inst->getName().c_str());
+				}
+				case Qt::DecorationRole: {
+					return StudioWindow::getClassIcon(QString(n->inst->getClassName().c_str()));
+				}
+			}
+
+			return QVariant();
+		}
+
+		bool InstanceTreeModel::setData(const QModelIndex& index, const QVariant& value, int role){
+			if(role != Qt::EditRole || !index.isValid()){
+				return false;
+			}
+
+			Node* n = nodeAt(index);
+			if(!n || !n->inst){
+				return false;
+			}
+
+			shared_ptr<Type::VarWrapper> oldName = make_shared<Type::VarWrapper>(n->inst->getName());
+
+			// The Changed event takes care of dataChanged
+			n->inst->setName(value.toString().toStdString());
+
+			UndoCommand* cmd = new UndoCommand("Rename");
+			cmd->addPropertyChange(n->inst, PropertyNames::intern("Name"), oldName, make_shared<Type::VarWrapper>(n->inst->getName()));
+			glWidget->recordUndo(cmd);
+
+			return true;
+		}
+
+		StudioGLWidget* InstanceTreeModel::getGLWidget(){
+			return glWidget;
+		}
+
+		Qt::ItemFlags InstanceTreeModel::flags(const QModelIndex& index) const{
+			if(!index.isValid()){
+				return Qt::ItemIsDropEnabled;
+			}
+
+			Qt::ItemFlags flags = Qt::ItemIsSelectable | Qt::ItemIsEditable | Qt::ItemIsDropEnabled | Qt::ItemIsEnabled;
+
+			Node* n = nodeAt(index);
+			if(n && n->inst && !n->inst->ParentLocked){
+				flags = flags | Qt::ItemIsDragEnabled;
+			}
+
+			return flags;
+		}
+
+		Qt::DropActions InstanceTreeModel::supportedDropActions() const{
+			return Qt::MoveAction;
+		}
+
+		shared_ptr<Instance::Instance> InstanceTreeModel::instanceAt(const QModelIndex& index) const{
+			if(!index.isValid()){
+				return NULL;
+			}
+
+			Node* n = nodeAt(index);
+			if(n){
+				return n->inst;
+			}
+			return NULL;
+		}
+
+		QModelIndex InstanceTreeModel::indexOf(shared_ptr<Instance::Instance> inst){
+			Node* n = nodeFor(inst);
+			if(n){
+				return indexForNode(n);
+			}
+
+			// Find the closest ancestor we already know about, then
+			// populate our way back down to inst
+			std::vector<shared_ptr<Instance::Instance>> lineage;
+			shared_ptr<Instance::Instance> cur = inst;
+			Node* known = NULL;
+			while(cur){
+				known = nodeFor(cur);
+				if(known){
+					break;
+				}
+				lineage.push_back(cur);
+				cur = cur->getParent();
+			}
+
+			if(!known){
+				// Not part of this tree
+				return QModelIndex();
+			}
+
+			for(auto it = lineage.rbegin(); it != lineage.rend(); ++it){
+				populate(known);
+
+				known = nodeFor(*it);
+				if(!known){
+					return QModelIndex();
+				}
+			}
+
+			return indexForNode(known);
+		}
+
+		QModelIndexList InstanceTreeModel::populatedIndexes() const{
+			QModelIndexList populated;
+
+			for(auto it = populatedNodes.begin(); it != populatedNodes.end(); ++it){
+				Node* n = *it;
+				if(n != rootNode && !n->children.empty()){
+					populated.append(indexForNode(n));
+				}
+			}
+
+			return populated;
+		}
+
+		InstanceTreeModel::Node* InstanceTreeModel::createNode(shared_ptr<Instance::Instance> inst, Node* parent, int row){
+			using namespace std::placeholders;
+
+			Node* n = new Node();
+			n->inst = inst;
+			n->parent = parent;
+			n->row = row;
+			n->populated = false;
+			n->childCount = inst->GetChildren().size();
+
+			nodeMap[inst.get()] = n;
+
+			std::weak_ptr<Instance::Instance> wInst = inst;
+			n->conns.push_back(inst->Changed->Connect(std::bind(&InstanceTreeModel::changed_evt, this, _1, wInst)));
+			n->conns.push_back(inst->ChildAdded->Connect(std::bind(&InstanceTreeModel::child_added_evt, this, _1, wInst)));
+			n->conns.push_back(inst->ChildRemoved->Connect(std::bind(&InstanceTreeModel::child_removed_evt, this, _1, wInst)));
+
+			return n;
+		}
+
+		void InstanceTreeModel::destroyNode(Node* n){
+			if(!n){
+				return;
+			}
+
+			for(size_t i = 0; i < n->children.size(); i++){
+				destroyNode(n->children[i]);
+			}
+
+			for(size_t i = 0; i < n->conns.size(); i++){
+				if(n->conns[i]){
+					n->conns[i]->Disconnect();
+				}
+			}
+
+			auto it = nodeMap.find(n->inst.get());
+			if(it != nodeMap.end() && it->second == n){
+				nodeMap.erase(it);
+			}
+			populatedNodes.erase(n);
+
+			delete n;
+		}
+
+		void InstanceTreeModel::populate(Node* n){
+			if(!n || n->populated){
+				return;
+			}
+			n->populated = true;
+			populatedNodes.insert(n);
+
+			// Rows are only announced for kids that are really there
+			std::vector<shared_ptr<Instance::Instance>> kids = n->inst->GetChildren();
+			kids.erase(std::remove(kids.begin(), kids.end(), shared_ptr<Instance::Instance>()), kids.end());
+
+			n->childCount = kids.size();
+			if(kids.empty()){
+				return;
+			}
+
+			beginInsertRows(indexForNode(n), 0, kids.size() - 1);
+			n->children.reserve(kids.size());
+			for(size_t i = 0; i < kids.size(); i++){
+				n->children.push_back(createNode(kids[i], n, i));
+			}
+			endInsertRows();
+		}
+
+		void InstanceTreeModel::insertNode(Node* parent, Node* n){
+			int row = parent->children.size();
+
+			beginInsertRows(indexForNode(parent), row, row);
+			n->parent = parent;
+			n->row = row;
+			parent->children.push_back(n);
+			parent->childCount = parent->children.size();
+			endInsertRows();
+		}
+
+		void InstanceTreeModel::takeNode(Node* n){
+			Node* parent = n->parent;
+			if(!parent){
+				return;
+			}
+
+			int row = n->row;
+
+			beginRemoveRows(indexForNode(parent), row, row);
+			parent->children.erase(parent->children.begin() + row);
+			for(size_t i = row; i < parent->children.size(); i++){
+				parent->children[i]->row = i;
+			}
+			parent->childCount = parent->children.size();
+			n->parent = NULL;
+			endRemoveRows();
+		}
+
+		void InstanceTreeModel::beginBatch(){
+			batchDepth++;
+		}
+
+		void InstanceTreeModel::endBatch(){
+			if(batchDepth == 0 || --batchDepth > 0){
+				return;
+			}
+
+			std::unordered_map<Instance::Instance*, std::weak_ptr<Instance::Instance>> parents;
+			parents.swap(batchParents);
+
+			std::vector<shared_ptr<Instance::Instance>> touched;
+			touched.reserve(parents.size());
+
+			// Take out everything that left first. Nodes are kept
+			// until every parent has been looked at, so an instance
+			// that moved keeps its expanded children.
+			std::unordered_map<Instance::Instance*, Node*> detached;
+			for(auto it = parents.begin(); it != parents.end(); ++it){
+				shared_ptr<Instance::Instance> parent = it->second.lock();
+				Node* pn = nodeFor(parent);
+				if(!pn){
+					continue;
+				}
+				touched.push_back(parent);
+
+				if(pn->populated){
+					removeDeparted(pn, detached);
+				}else{
+					pn->childCount = parent->GetChildren().size();
+
+					QModelIndex pIdx = indexForNode(pn);
+					emit dataChanged(pIdx, pIdx);
+				}
+			}
+
+			for(size_t i = 0; i < touched.size(); i++){
+				Node* pn = nodeFor(touched[i]);
+				if(pn && pn->populated){
+					appendArrived(pn, detached);
+				}
+			}
+
+			// Whatever is left is no longer under anything we show
+			for(auto it = detached.begin(); it != detached.end(); ++it){
+				destroyNode(it->second);
+			}
+
+			for(size_t i = 0; i < touched.size(); i++){
+				glWidget->instance_children_changed(touched[i]);
+			}
+		}
+
+		void InstanceTreeModel::removeDeparted(Node* pn, std::unordered_map<Instance::Instance*, Node*>& detached){
+			std::vector<shared_ptr<Instance::Instance>> kids = pn->inst->GetChildren();
+			std::unordered_set<Instance::Instance*> stillHere;
+			stillHere.reserve(kids.size());
+			for(size_t i = 0; i < kids.size(); i++){
+				stillHere.insert(kids[i].get());
+			}
+
+			QModelIndex pIdx = indexForNode(pn);
+
+			// One removal per run of departed rows, back to front so
+			// the rows ahead of each run don't move
+			int last = (int)pn->children.size() - 1;
+			while(last >= 0){
+				if(stillHere.count(pn->children[last]->inst.get())){
+					last--;
+					continue;
+				}
+
+				int first = last;
+				while(first > 0 && !stillHere.count(pn->children[first - 1]->inst.get())){
+					first--;
+				}
+
+				beginRemoveRows(pIdx, first, last);
+				for(int r = first; r <= last; r++){
+					Node* kn = pn->children[r];
+					kn->parent = NULL;
+					detached[kn->inst.get()] = kn;
+				}
+				pn->children.erase(pn->children.begin() + first, pn->children.begin() + last + 1);
+				for(size_t r = first; r < pn->children.size(); r++){
+					pn->children[r]->row = r;
+				}
+				pn->childCount = pn->children.size();
+				endRemoveRows();
+
+				last = first - 1;
+			}
+		}
+
+		void InstanceTreeModel::appendArrived(Node* pn, std::unordered_map<Instance::Instance*, Node*>& detached){
+			std::vector<shared_ptr<Instance::Instance>> kids = pn->inst->GetChildren();
+
+			std::vector<shared_ptr<Instance::Instance>> arrived;
+			for(size_t i = 0; i < kids.size(); i++){
+				if(!kids[i]){
+					continue;
+				}
+
+				Node* kn = nodeFor(kids[i]);
+				if(kn && kn->parent == pn){
+					continue;
+				}
+				if(kn && kn->parent){
+					// Its old parent wasn't part of the batch
+					takeNode(kn);
+					detached[kids[i].get()] = kn;
+				}
+				arrived.push_back(kids[i]);
+			}
+
+			if(arrived.empty()){
+				return;
+			}
+
+			int row = pn->children.size();
+
+			beginInsertRows(indexForNode(pn), row, row + arrived.size() - 1);
+			pn->children.reserve(row + arrived.size());
+			for(size_t i = 0; i < arrived.size(); i++){
+				Node* kn = NULL;
+
+				auto dIt = detached.find(arrived[i].get());
+				if(dIt != detached.end()){
+					kn = dIt->second;
+					detached.erase(dIt);
+
+					kn->parent = pn;
+					kn->row = pn->children.size();
+				}else{
+					kn = createNode(arrived[i], pn, pn->children.size());
+				}
+
+				pn->children.push_back(kn);
+			}
+			pn->childCount = pn->children.size();
+			endInsertRows();
+		}
+
+		void InstanceTreeModel::childAdded(shared_ptr<Instance::Instance> parent, shared_ptr<Instance::Instance> kid){
+			if(batchDepth > 0){
+				if(parent){
+					batchParents[parent.get()] = parent;
+				}
+				return;
+			}
+
+			Node* pn = nodeFor(parent);
+			if(!pn || !kid){
+				return;
+			}
+
+			Node* kn = nodeFor(kid);
+			if(kn && kn->parent == pn){
+				return;
+			}
+
+			if(!pn->populated){
+				// Nobody has looked inside yet, just keep the expander right
+				if(kn){
+					takeNode(kn);
+					destroyNode(kn);
+				}
+				pn->childCount++;
+
+				QModelIndex pIdx = indexForNode(pn);
+				emit dataChanged(pIdx, pIdx);
+			}else if(kn){
+				takeNode(kn);
+				insertNode(pn, kn);
+			}else{
+				insertNode(pn, createNode(kid, pn, pn->children.size()));
+			}
+
+			glWidget->instance_children_changed(parent);
+		}
+
+		void InstanceTreeModel::childRemoved(shared_ptr<Instance::Instance> parent, shared_ptr<Instance::Instance> kid){
+			if(batchDepth > 0){
+				if(parent){
+					batchParents[parent.get()] = parent;
+				}
+				return;
+			}
+
+			Node* pn = nodeFor(parent);
+			if(!pn || !kid){
+				return;
+			}
+
+			if(!pn->populated){
+				if(pn->childCount > 0){
+					pn->childCount--;
+				}
+
+				QModelIndex pIdx = indexForNode(pn);
+				emit dataChanged(pIdx, pIdx);
+			}else{
+				Node* kn = nodeFor(kid);
+				// If it already moved somewhere else, ChildAdded beat us here
+				if(kn && kn->parent == pn){
+					takeNode(kn);
+					destroyNode(kn);
+				}
+			}
+
+			glWidget->instance_children_changed(parent);
+		}
+
+		bool InstanceTreeModel::isDisplayedProperty(const std::string& prop){
+			return prop == "Name" || prop == "Parent" || prop == "ParentLocked";
+		}
+
+		void InstanceTreeModel::instanceChanged(shared_ptr<Instance::Instance> inst){
+			Node* n = nodeFor(inst);
+			if(n && n != rootNode){
+				QModelIndex idx = indexForNode(n);
+				emit dataChanged(idx, idx);
+			}
+		}
+
+		// Engine events may come from a tick thread, so everything is
+		// bounced through the GUI thread and resolved by instance there.
+		// Property changes are batched up by the tab and come back
+		// through instanceChanged() once per frame.
+		void InstanceTreeModel::changed_evt(std::vector<shared_ptr<Type::VarWrapper>> evec, std::weak_ptr<Instance::Instance> inst){
+			if(evec.size() != 1){
+				return;
+			}
+
+			glWidget->instance_changed_evt(inst, evec.at(0)->asString());
+		}
+
+		void InstanceTreeModel::child_added_evt(std::vector<shared_ptr<Type::VarWrapper>> evec, std::weak_ptr<Instance::Instance> inst){
+			if(evec.size() != 1){
+				return;
+			}
+
+			shared_ptr<Instance::Instance> kid = evec.at(0)->asInstance();
+			glWidget->runOnGui([this, inst, kid](){
+				shared_ptr<Instance::Instance> sInst = inst.lock();
+				if(sInst){
+					childAdded(sInst, kid);
+				}
+			});
+		}
+
+		void InstanceTreeModel::child_removed_evt(std::vector<shared_ptr<Type::VarWrapper>> evec, std::weak_ptr<Instance::Instance> inst){
+			if(evec.size() != 1){
+				return;
+			}
+
+			shared_ptr<Instance::Instance> kid = evec.at(0)->asInstance();
+			glWidget->runOnGui([this, inst, kid](){
+				shared_ptr<Instance::Instance> sInst = inst.lock();
+				if(sInst){
+					childRemoved(sInst, kid);
+				}
+			});
+		}
+	}
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OB_STUDIO_INSTANCETREEMODEL_H_
+#define OB_STUDIO_INSTANCETREEMODEL_H_
+
+#include <QAbstractItemModel>
+
+#include <instance/Instance.h>
+#include <type/EventConnection.h>
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace OB{
+	namespace Studio{
+		class StudioGLWidget;
+
+		/*
+		 * Explorer model backed directly by an engine's instance
+		 * hierarchy.
+		 *
+		 * A node is only created for an instance once its parent has
+		 * been fetched (expanded, or revealed by indexOf), so the cost
+		 * of a place is proportional to what the user has looked at,
+		 * not to its size. Nodes know their own row, which keeps
+		 * index(), parent() and rowCount() constant time.
+		 */
+		class InstanceTreeModel: public QAbstractItemModel{
+		public:
+			InstanceTreeModel(StudioGLWidget* glWidget, shared_ptr<Instance::Instance> root);
+			virtual ~InstanceTreeModel();
+
+			virtual QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const;
+			virtual QModelIndex parent(const QModelIndex& index) const;
+			virtual int rowCount(const QModelIndex& parent = QModelIndex()) const;
+			virtual int columnCount(const QModelIndex& parent = QModelIndex()) const;
+			virtual bool hasChildren(const QModelIndex& parent = QModelIndex()) const;
+			virtual bool canFetchMore(const QModelIndex& parent) const;
+			virtual void fetchMore(const QModelIndex& parent);
+
+			virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+			virtual bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole);
+			virtual Qt::ItemFlags flags(const QModelIndex& index) const;
+			virtual Qt::DropActions supportedDropActions() const;
+
+			shared_ptr<Instance::Instance> instanceAt(const QModelIndex& index) const;
+			QModelIndex indexOf(shared_ptr<Instance::Instance> inst);
+			QModelIndexList populatedIndexes() const;
+
+			StudioGLWidget* getGLWidget();
+
+			// Between these, child changes only note which parents were
+			// touched. Each of those is brought up to date once at the
+			// end, so moving thousands of instances isn't thousands of
+			// row inserts and removals.
+			void beginBatch();
+			void endBatch();
+
+			void childAdded(shared_ptr<Instance::Instance> parent, shared_ptr<Instance::Instance> kid);
+			void childRemoved(shared_ptr<Instance::Instance> parent, shared_ptr<Instance::Instance> kid);
+			void instanceChanged(shared_ptr<Instance::Instance> inst);
+
+			static bool isDisplayedProperty(const std::string& prop);
+
+		private:
+			struct Node{
+				shared_ptr<Instance::Instance> inst;
+				Node* parent;
+				int row;
+
+				bool populated;
+				int childCount;
+				std::vector<Node*> children;
+
+				std::vector<shared_ptr<Type::EventConnection>> conns;
+			};
+
+			Node* nodeAt(const QModelIndex& index) const;
+			Node* nodeFor(shared_ptr<Instance::Instance> inst) const;
+			QModelIndex indexForNode(Node* n) const;
+
+			Node* createNode(shared_ptr<Instance::Instance> inst, Node* parent, int row);
+			void destroyNode(Node* n);
+			void populate(Node* n);
+
+			void insertNode(Node* parent, Node* n);
+			void takeNode(Node* n);
+
+			void removeDeparted(Node* pn, std::unordered_map<Instance::Instance*, Node*>& detached);
+			void appendArrived(Node* pn, std::unordered_map<Instance::Instance*, Node*>& detached);
+
+			void changed_evt(std::vector<shared_ptr<Type::VarWrapper>> evec, std::weak_ptr<Instance::Instance> inst);
+			void child_added_evt(std::vector<shared_ptr<Type::VarWrapper>> evec, std::weak_ptr<Instance::Instance> inst);
+			void child_removed_evt(std::vector<shared_ptr<Type::VarWrapper>> evec, std::weak_ptr<Instance::Instance> inst);
+
+			StudioGLWidget* glWidget;
+
+			Node* rootNode;
+			std::unordered_map<Instance::Instance*, Node*> nodeMap;
+			std::unordered_set<Node*> populatedNodes;
+
+			int batchDepth;
+			std::unordered_map<Instance::Instance*, std::weak_ptr<Instance::Instance>> batchParents;
+		};
+	}
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "LogFileSink.h"
+
+#include "FileWriterThread.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QStandardPaths>
+
+#include <zlib.h>
+
+namespace OB{
+	namespace Studio{
+		// Only ever touched on the writer thread
+		struct LogFileSink::File{
+			QString path;
+			qint64 maxBytes;
+			int maxFiles;
+			bool compress;
+
+			QFile out;
+			qint64 size;
+
+			QString rotatedPath(int n, bool gz){
+				return path + "." + QString::number(n) + (gz ? ".gz" : "");
+			}
+
+			// Writes a gzip file zcat and friends can read
+			static bool gzipFile(QString from, QString to){
+				QFile raw(from);
+				if(!raw.open(QIODevice::ReadOnly)){
+					return false;
+				}
+
+				gzFile gz = gzopen(QFile::encodeName(to).constData(), "wb");
+				if(!gz){
+					return false;
+				}
+
+				bool ok = true;
+				while(ok && !raw.atEnd()){
+					QByteArray chunk = raw.read(64 * 1024);
+					if(chunk.isEmpty() || gzwrite(gz, chunk.constData(), chunk.size()) != chunk.size()){
+						ok = false;
+					}
+				}
+
+				if(gzclose(gz) != Z_OK){
+					ok = false;
+				}
+				if(!ok){
+					QFile::remove(to);
+				}
+				return ok;
+			}
+
+			void rotate(){
+				out.close();
+
+				// A rotated file is plain if compressing it failed, so
+				// both names move along
+				QFile::remove(rotatedPath(maxFiles, false));
+				QFile::remove(rotatedPath(maxFiles, true));
+				for(int i = maxFiles - 1; i > 0; i--){
+					QFile::rename(rotatedPath(i, false), rotatedPath(i + 1, false));
+					QFile::rename(rotatedPath(i, true), rotatedPath(i + 1, true));
+				}
+
+				if(maxFiles < 1){
+					QFile::remove(path);
+					return;
+				}
+
+				if(compress && gzipFile(path, rotatedPath(1, true))){
+					QFile::remove(path);
+					return;
+				}
+
+				QFile::rename(path, rotatedPath(1, false));
+			}
+
+			void write(QByteArray data){
+				if(!out.isOpen()){
+					QDir().mkpath(QFileInfo(path).absolutePath());
+
+					out.setFileName(path);
+					if(!out.open(QIODevice::WriteOnly | QIODevice::Append)){
+						return;
+					}
+					size = out.size();
+				}
+
+				size += out.write(data);
+				out.flush();
+
+				if(size >= maxBytes){
+					rotate();
+				}
+			}
+		};
+
+		static FileWriterThread* ob_studio_log_writer = NULL;
+
+		static void ob_studio_log_post(std::function<void()> job){
+			if(!ob_studio_log_writer){
+				ob_studio_log_writer = new FileWriterThread();
+				ob_studio_log_writer->start(QThread::LowPriority);
+			}
+			ob_studio_log_writer->post(job);
+		}
+
+		LogFileSink::LogFileSink(QString path, qint64 maxBytes, int maxFiles, bool compress){
+			file = std::make_shared<File>();
+			file->path = path;
+			file->maxBytes = qMax((qint64)1024, maxBytes);
+			file->maxFiles = qMax(0, maxFiles);
+			file->compress = compress;
+			file->size = 0;
+		}
+
+		LogFileSink::~LogFileSink(){
+			flush();
+
+			std::shared_ptr<File> f = file;
+			ob_studio_log_post([f](){
+				f->out.close();
+			});
+		}
+
+		QString LogFileSink::getPath(){
+			return file->path;
+		}
+
+		void LogFileSink::write(qint64 timestamp, OutputLevel level, QString text){
+			const char* levelName = "INFO";
+			if(level == OutputLevel::Warning){
+				levelName = "WARN";
+			}else if(level == OutputLevel::Error){
+				levelName = "ERROR";
+			}
+
+			batch.append(QDateTime::fromMSecsSinceEpoch(timestamp).toString("yyyy-MM-dd hh:mm:ss.zzz").toUtf8());
+			batch.append(" [");
+			batch.append(levelName);
+			batch.append("] ");
+			batch.append(text.toUtf8());
+			batch.append('\n');
+		}
+
+		void LogFileSink::flush(){
+			if(batch.isEmpty()){
+				return;
+			}
+
+			std::shared_ptr<File> f = file;
+			QByteArray data = batch;
+			batch.clear();
+
+			ob_studio_log_post([f, data](){
+				f->write(data);
+			});
+		}
+
+		QString LogFileSink::getLogRoot(){
+			return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/logs";
+		}
+
+		QString LogFileSink::newLogPath(){
+			static int serial = 0;
+			serial++;
+
+			QString stamp = QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss");
+			return getLogRoot() + "/" + stamp + "-" + QString::number(QCoreApplication::applicationPid()) + "-" + QString::number(serial) + ".log";
+		}
+
+		void LogFileSink::shutdown(){
+			if(ob_studio_log_writer){
+				ob_studio_log_writer->requestStop();
+				ob_studio_log_writer->wait();
+
+				delete ob_studio_log_writer;
+				ob_studio_log_writer = NULL;
+			}
+		}
+	}
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OB_STUDIO_LOGFILESINK_H_
+#define OB_STUDIO_LOGFILESINK_H_
+
+#include "OutputLog.h"
+
+#include <QString>
+#include <QByteArray>
+
+#include <memory>
+
+#define OB_STUDIO_DEFAULT_LOG_FILE_SIZE (4 * 1024 * 1024)
+#define OB_STUDIO_DEFAULT_LOG_FILES 5
+
+namespace OB{
+	namespace Studio{
+		/*
+		 * Writes a tab's log messages to a file.
+		 *
+		 * Lines are batched on the GUI thread and handed to a shared
+		 * writer thread once per flush(), so the GUI never waits on
+		 * the disk. Once the file reaches maxBytes it is rotated to
+		 * name.log.1, name.log.1 to name.log.2 and so on, keeping
+		 * maxFiles old files. Rotated files can be gzipped, and get a
+		 * .gz suffix when they are.
+		 */
+		class LogFileSink{
+		public:
+			LogFileSink(QString path, qint64 maxBytes = OB_STUDIO_DEFAULT_LOG_FILE_SIZE, int maxFiles = OB_STUDIO_DEFAULT_LOG_FILES, bool compress = false);
+			virtual ~LogFileSink();
+
+			QString getPath();
+
+			void write(qint64 timestamp, OutputLevel level, QString text);
+			void flush();
+
+			static QString getLogRoot();
+			static QString newLogPath();
+
+			// Waits for everything posted so far to be written
+			static void shutdown();
+
+		private:
+			struct File;
+			std::shared_ptr<File> file;
+
+			QByteArray batch;
+		};
+	}
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// End:
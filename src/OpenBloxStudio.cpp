@@ -22,13 +22,17 @@
 #include <QApplication>
 #include <QSettings>
 #include <QFile>
+#include <QDir>
 #include <QTextStream>
 #include <QCommandLineParser>
-#include <QThread>
 #include <QStringListModel>
+#include <QMessageBox>
 
 #include "StudioWindow.h"
 #include "StudioGLWidget.h"
+#include "FrameScheduler.h"
+#include "AutosaveJournal.h"
+#include "ClassIconTable.h"
 
 #include <instance/NetworkServer.h>
 #include <instance/NetworkClient.h>
@@ -115,9 +119,14 @@ int main(int argc, char** argv){
 	OB::ClassFactory::registerCoreClasses();
 	OB::Instance::Selection::registerClass();
 
+	OB::Studio::ClassIconTable::build();
+
 	OB::Studio::StudioWindow* win = new OB::Studio::StudioWindow();
 	win->settingsInst = settings;
 
+	win->scheduler = new OB::Studio::FrameScheduler(win);
+	win->scheduler->loadSettings(settings);
+
 	settings->beginGroup("main_window");
 	{
 		if(settings->contains("geometry")){
@@ -137,6 +146,8 @@ int main(int argc, char** argv){
 		if(settings->contains("max_history")){
 			cmdBar->setMaxCount(settings->value("max_history").toInt());
 		}
+		win->commandCache->setMaxEntries(cmdBar->maxCount());
+		win->commandCache->readSettings(settings);
 		if(settings->contains("history")){
 			cmdBar->addItems(settings->value("history").toStringList());
 			cmdBar->setCurrentIndex(cmdBar->count());
@@ -145,6 +156,73 @@ int main(int argc, char** argv){
 	}
 	settings->endGroup();
 
+	settings->beginGroup("autosave");
+	{
+		if(settings->contains("interval")){
+			win->setAutosaveInterval(settings->value("interval").toInt());
+		}
+	}
+	settings->endGroup();
+
+	settings->beginGroup("undo");
+	{
+		// In MiB
+		if(settings->contains("memory_limit")){
+			win->setUndoMemoryLimit((size_t)settings->value("memory_limit").toUInt() * 1024 * 1024);
+		}
+	}
+	settings->endGroup();
+
+	settings->beginGroup("output");
+	{
+		if(settings->contains("max_lines")){
+			win->setOutputLimit(settings->value("max_lines").toInt());
+		}
+		// Lines per second for each message level, 0 for no limit
+		if(settings->contains("rate_limit")){
+			win->setOutputRateLimit(settings->value("rate_limit").toInt());
+		}
+	}
+	settings->endGroup();
+
+	settings->beginGroup("log_file");
+	{
+		if(settings->value("enabled", false).toBool()){
+			// Size in KiB
+			qint64 maxBytes = OB_STUDIO_DEFAULT_LOG_FILE_SIZE;
+			if(settings->contains("max_size")){
+				maxBytes = settings->value("max_size").toLongLong() * 1024;
+			}
+			int maxFiles = settings->value("max_files", OB_STUDIO_DEFAULT_LOG_FILES).toInt();
+			bool compress = settings->value("compress", false).toBool();
+
+			win->setLogToFile(true, maxBytes, maxFiles, compress);
+		}
+	}
+	settings->endGroup();
+
+	settings->beginGroup("command_bar");
+	{
+		// Milliseconds of script per frame
+		if(settings->contains("time_slice")){
+			win->setCommandTimeSlice(settings->value("time_slice").toInt());
+		}
+	}
+	settings->endGroup();
+
+	// Journals left behind by a Studio that didn't close cleanly
+	QStringList recoverable = OB::Studio::AutosaveJournal::findRecoverable();
+	if(!recoverable.isEmpty()){
+		QMessageBox::StandardButton answer = QMessageBox::question(win, "Recover Games", "OpenBlox Studio did not close cleanly. Recover unsaved games?", QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes);
+		for(int i = 0; i < recoverable.size(); i++){
+			if(answer == QMessageBox::Yes){
+				win->loadGame(recoverable.at(i));
+			}else{
+				QDir(recoverable.at(i)).removeRecursively();
+			}
+		}
+	}
+
 	if(parser.isSet(newOpt) || parser.isSet(serverOpt) || parser.isSet(clientOpt)){
 		win->newInstance();
 		OB::OBEngine* eng = win->getCurrentEngine();
@@ -201,11 +279,7 @@ int main(int argc, char** argv){
 		}
 	}
 
-	while(win->isVisible()){
-		app.processEvents();
-		win->tickEngines();
-		QThread::msleep(10);
-	}
+	win->scheduler->start();
 
-	return 0;
+	return app.exec();
 }
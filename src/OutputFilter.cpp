@@ -0,0 +1,402 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "OutputFilter.h"
+
+#include <QApplication>
+#include <QPainter>
+
+#include <algorithm>
+
+namespace OB{
+	namespace Studio{
+		OutputFilter::OutputFilter(){
+			log = NULL;
+
+			levels = OB_STUDIO_OUTPUT_ALL_LEVELS;
+			regex = false;
+			active = false;
+		}
+
+		OutputFilter::~OutputFilter(){}
+
+		int OutputFilter::rowCount(const QModelIndex& parent) const{
+			if(parent.isValid() || !log){
+				return 0;
+			}
+			if(!active){
+				return log->rowCount();
+			}
+			return matched.size();
+		}
+
+		QVariant OutputFilter::data(const QModelIndex& index, int role) const{
+			if(!index.isValid() || !log){
+				return QVariant();
+			}
+
+			int row = index.row();
+			if(active){
+				if(row >= matched.size()){
+					return QVariant();
+				}
+				row = matched[row] - log->getFirstSequence();
+			}
+			return log->data(log->index(row), role);
+		}
+
+		void OutputFilter::setLog(OutputLog* log){
+			if(this->log == log){
+				return;
+			}
+
+			beginResetModel();
+
+			if(this->log){
+				disconnect(this->log, 0, this, 0);
+			}
+			this->log = log;
+			rescan();
+
+			if(log){
+				// The log only ever appends at the end, drops from the
+				// front, changes its last row or resets
+				connect(log, &QAbstractItemModel::rowsAboutToBeInserted, this, [this](const QModelIndex&, int first, int last){
+					if(!active){
+						beginInsertRows(QModelIndex(), first, last);
+					}
+				});
+				connect(log, &QAbstractItemModel::rowsInserted, this, [this](const QModelIndex&, int first, int last){
+					if(!active){
+						endInsertRows();
+						return;
+					}
+
+					qint64 firstSeq = this->log->getFirstSequence();
+					QVector<qint64> added;
+					for(int i = first; i <= last; i++){
+						if(matches(this->log->recordAt(i))){
+							added.append(firstSeq + i);
+						}
+					}
+
+					if(!added.isEmpty()){
+						beginInsertRows(QModelIndex(), matched.size(), matched.size() + added.size() - 1);
+						matched += added;
+						endInsertRows();
+					}
+				});
+				connect(log, &QAbstractItemModel::rowsAboutToBeRemoved, this, [this](const QModelIndex&, int first, int last){
+					if(!active){
+						beginRemoveRows(QModelIndex(), first, last);
+						return;
+					}
+
+					qint64 lastSeq = this->log->getFirstSequence() + last;
+					int n = std::upper_bound(matched.begin(), matched.end(), lastSeq) - matched.begin();
+					if(n > 0){
+						beginRemoveRows(QModelIndex(), 0, n - 1);
+						matched.remove(0, n);
+						endRemoveRows();
+					}
+				});
+				connect(log, &QAbstractItemModel::rowsRemoved, this, [this](const QModelIndex&, int, int){
+					if(!active){
+						endRemoveRows();
+					}
+				});
+				connect(log, &QAbstractItemModel::dataChanged, this, [this](const QModelIndex& topLeft, const QModelIndex& bottomRight){
+					if(!active){
+						emit dataChanged(index(topLeft.row()), index(bottomRight.row()));
+						return;
+					}
+
+					qint64 firstSeq = this->log->getFirstSequence();
+					for(int i = topLeft.row(); i <= bottomRight.row(); i++){
+						auto it = std::lower_bound(matched.begin(), matched.end(), firstSeq + i);
+						if(it != matched.end() && *it == firstSeq + i){
+							QModelIndex idx = index(it - matched.begin());
+							emit dataChanged(idx, idx);
+						}
+					}
+				});
+				connect(log, &QAbstractItemModel::modelAboutToBeReset, this, [this](){
+					beginResetModel();
+				});
+				connect(log, &QAbstractItemModel::modelReset, this, [this](){
+					rescan();
+					endResetModel();
+				});
+			}
+
+			endResetModel();
+		}
+
+		OutputLog* OutputFilter::getLog(){
+			return log;
+		}
+
+		void OutputFilter::setFilter(int levels, QString pattern, bool regex){
+			levels &= OB_STUDIO_OUTPUT_ALL_LEVELS;
+
+			// Only ever fewer lines than now, so only those are tested.
+			// The index does better once there's a trigram to go on.
+			bool narrowing = active && !regex && !this->regex && (levels & ~this->levels) == 0 && pattern.contains(this->pattern, Qt::CaseInsensitive) && pattern.size() < 3;
+
+			beginResetModel();
+
+			this->levels = levels;
+			this->pattern = pattern;
+			this->regex = regex;
+			re = QRegularExpression();
+			if(regex){
+				re = QRegularExpression(pattern);
+			}
+			active = levels != OB_STUDIO_OUTPUT_ALL_LEVELS || !pattern.isEmpty();
+
+			if(narrowing && log){
+				qint64 firstSeq = log->getFirstSequence();
+
+				int kept = 0;
+				for(int i = 0; i < matched.size(); i++){
+					if(matches(log->recordAt(matched[i] - firstSeq))){
+						matched[kept++] = matched[i];
+					}
+				}
+				matched.resize(kept);
+			}else{
+				rescan();
+			}
+
+			endResetModel();
+		}
+
+		bool OutputFilter::isActive(){
+			return active;
+		}
+
+		QString OutputFilter::getError(){
+			if(regex && !re.isValid()){
+				return re.errorString();
+			}
+			return QString();
+		}
+
+		QVector<QPair<int, int>> OutputFilter::matchSpans(const QString& text) const{
+			QVector<QPair<int, int>> spans;
+			if(pattern.isEmpty()){
+				return spans;
+			}
+
+			if(regex){
+				if(!re.isValid()){
+					return spans;
+				}
+
+				QRegularExpressionMatchIterator it = re.globalMatch(text);
+				while(it.hasNext()){
+					QRegularExpressionMatch m = it.next();
+					if(m.capturedLength() > 0){
+						spans.append(qMakePair(m.capturedStart(), m.capturedLength()));
+					}
+				}
+			}else{
+				int at = text.indexOf(pattern, 0, Qt::CaseInsensitive);
+				while(at >= 0){
+					spans.append(qMakePair(at, pattern.size()));
+					at = text.indexOf(pattern, at + pattern.size(), Qt::CaseInsensitive);
+				}
+			}
+
+			return spans;
+		}
+
+		bool OutputFilter::matches(const OutputRecord& rec) const{
+			if(!(levels & (1 << (int)rec.level))){
+				return false;
+			}
+			if(pattern.isEmpty()){
+				return true;
+			}
+			if(regex){
+				return re.isValid() && re.match(rec.text).hasMatch();
+			}
+			return rec.text.contains(pattern, Qt::CaseInsensitive);
+		}
+
+		// The longest run of plain characters every match of pattern
+		// has to contain, or nothing if there's no telling
+		static QString ob_studio_regex_literal(const QString& pattern){
+			// Alternatives and groups could make anything optional
+			if(pattern.contains('|') || pattern.contains('(')){
+				return QString();
+			}
+
+			QString best;
+			QString run;
+			auto endRun = [&](){
+				if(run.size() > best.size()){
+					best = run;
+				}
+				run.clear();
+			};
+
+			for(int i = 0; i < pattern.size(); i++){
+				QChar c = pattern[i];
+				if(c == '\\'){
+					if(i + 1 >= pattern.size()){
+						break;
+					}
+					QChar next = pattern[++i];
+					if(QString("xcQoN0123456789").contains(next)){
+						// These change what the characters after them
+						// mean (\x41, \cA, \Q.*\E, \N{U+41}, octal),
+						// easier to fall back to a full scan
+						return QString();
+					}else if(next.isLetterOrNumber()){
+						// \d, \w, \b and friends aren't literals
+						endRun();
+					}else{
+						run.append(next);
+					}
+				}else if(c == '*' || c == '?' || c == '{'){
+					// The character before is optional
+					run.chop(1);
+					endRun();
+					if(c == '{'){
+						i = pattern.indexOf('}', i);
+						if(i < 0){
+							break;
+						}
+					}
+				}else if(c == '['){
+					endRun();
+					i = pattern.indexOf(']', i + 2);
+					if(i < 0){
+						break;
+					}
+				}else if(c == '+'){
+					// The character before is still there once, but
+					// what follows may come after more of it
+					QString last = run.right(1);
+					endRun();
+					run = last;
+				}else if(c == '.' || c == '^' || c == '$'){
+					endRun();
+				}else{
+					run.append(c);
+				}
+			}
+			endRun();
+
+			return best;
+		}
+
+		void OutputFilter::rescan(){
+			matched.clear();
+			if(!log || !active){
+				return;
+			}
+
+			qint64 firstSeq = log->getFirstSequence();
+			const OutputIndex& index = log->getIndex();
+
+			// Narrow it down with the index where possible, then test
+			// just those lines
+			QVector<qint64> candidates;
+			bool indexed = false;
+
+			QString literal = pattern;
+			if(regex){
+				literal = re.isValid() ? ob_studio_regex_literal(pattern) : QString();
+			}
+			if(!literal.isEmpty()){
+				indexed = index.linesContaining(literal, &candidates);
+			}
+			if(!indexed && levels != OB_STUDIO_OUTPUT_ALL_LEVELS){
+				index.linesWithLevels(levels, &candidates);
+				indexed = true;
+			}
+
+			if(indexed){
+				for(int i = 0; i < candidates.size(); i++){
+					if(matches(log->recordAt(candidates[i] - firstSeq))){
+						matched.append(candidates[i]);
+					}
+				}
+				return;
+			}
+
+			int count = log->rowCount();
+			for(int i = 0; i < count; i++){
+				if(matches(log->recordAt(i))){
+					matched.append(firstSeq + i);
+				}
+			}
+		}
+
+		OutputDelegate::OutputDelegate(OutputFilter* filter, QObject* parent) : QStyledItemDelegate(parent){
+			this->filter = filter;
+		}
+
+		OutputDelegate::~OutputDelegate(){}
+
+		void OutputDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const{
+			QStyleOptionViewItem opt = option;
+			initStyleOption(&opt, index);
+
+			QVector<QPair<int, int>> spans = filter->matchSpans(opt.text);
+			if(spans.isEmpty()){
+				QStyledItemDelegate::paint(painter, option, index);
+				return;
+			}
+
+			// Background and selection as usual, then the text by hand
+			// so the matches can go under it
+			QString text = opt.text;
+			opt.text = QString();
+
+			QStyle* style = opt.widget ? opt.widget->style() : QApplication::style();
+			style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, opt.widget);
+
+			QRect textRect = style->subElementRect(QStyle::SE_ItemViewItemText, &opt, opt.widget);
+			int margin = style->pixelMetric(QStyle::PM_FocusFrameHMargin, NULL, opt.widget) + 1;
+			textRect.adjust(margin, 0, -margin, 0);
+
+			painter->save();
+			painter->setClipRect(textRect);
+
+			QFontMetrics fm(opt.font);
+			QColor highlight(255, 220, 0, 110);
+			for(int i = 0; i < spans.size(); i++){
+				int x = fm.width(text.left(spans[i].first));
+				int w = fm.width(text.mid(spans[i].first, spans[i].second));
+				painter->fillRect(QRect(textRect.left() + x, textRect.top(), w, textRect.height()), highlight);
+			}
+
+			bool selected = opt.state & QStyle::State_Selected;
+			QPalette::ColorGroup cg = (opt.state & QStyle::State_Enabled) ? QPalette::Normal : QPalette::Disabled;
+			painter->setPen(opt.palette.color(cg, selected ? QPalette::HighlightedText : QPalette::Text));
+			painter->setFont(opt.font);
+			painter->drawText(textRect, opt.displayAlignment, text);
+
+			painter->restore();
+		}
+	}
+}
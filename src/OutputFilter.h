@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OB_STUDIO_OUTPUTFILTER_H_
+#define OB_STUDIO_OUTPUTFILTER_H_
+
+#include "OutputLog.h"
+
+#include <QAbstractListModel>
+#include <QStyledItemDelegate>
+#include <QRegularExpression>
+#include <QVector>
+#include <QPair>
+
+#define OB_STUDIO_OUTPUT_ALL_LEVELS ((1 << OB_STUDIO_OUTPUT_LEVELS) - 1)
+
+namespace OB{
+	namespace Studio{
+		/*
+		 * The lines of an OutputLog that pass the output dock's
+		 * filter bar.
+		 *
+		 * A new filter starts from the log's OutputIndex: the lines
+		 * holding the rarest trigram of the substring, or of the
+		 * longest literal a regex needs, or those of the wanted
+		 * levels. Only those are tested. A pattern too short for
+		 * trigrams falls back to testing every line, or the lines
+		 * that matched already when it's only been typed onto.
+		 *
+		 * Matches are kept as the log's sequence numbers, so only new
+		 * lines are tested as they arrive, and lines dropping off the
+		 * log's ring only trim the front. With nothing filtered, rows
+		 * pass straight through.
+		 */
+		class OutputFilter: public QAbstractListModel{
+		public:
+			OutputFilter();
+			virtual ~OutputFilter();
+
+			virtual int rowCount(const QModelIndex& parent = QModelIndex()) const;
+			virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+
+			void setLog(OutputLog* log);
+			OutputLog* getLog();
+
+			// levels is a mask of 1 << OutputLevel
+			void setFilter(int levels, QString pattern, bool regex);
+			bool isActive();
+			QString getError();
+
+			// (start, length) of each match of the pattern in text
+			QVector<QPair<int, int>> matchSpans(const QString& text) const;
+
+		private:
+			bool matches(const OutputRecord& rec) const;
+			void rescan();
+
+			OutputLog* log;
+
+			int levels;
+			QString pattern;
+			bool regex;
+			QRegularExpression re;
+			bool active;
+
+			QVector<qint64> matched;
+		};
+
+		// Paints output rows with filter matches highlighted
+		class OutputDelegate: public QStyledItemDelegate{
+		public:
+			OutputDelegate(OutputFilter* filter, QObject* parent = NULL);
+			virtual ~OutputDelegate();
+
+			virtual void paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const;
+
+		private:
+			OutputFilter* filter;
+		};
+	}
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "OutputIndex.h"
+
+#include "OutputLog.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace OB{
+	namespace Studio{
+		OutputIndex::Postings::Postings(){
+			head = 0;
+		}
+
+		int OutputIndex::Postings::size() const{
+			return lines.size() - head;
+		}
+
+		void OutputIndex::Postings::dropThrough(qint64 seq){
+			while(head < lines.size() && lines[head] <= seq){
+				head++;
+			}
+
+			// Only copy once half the list is dead
+			if(head > 32 && head * 2 > lines.size()){
+				lines.remove(0, head);
+				head = 0;
+			}
+		}
+
+		bool OutputIndex::Postings::contains(qint64 seq) const{
+			return std::binary_search(lines.constBegin() + head, lines.constEnd(), seq);
+		}
+
+		OutputIndex::OutputIndex(){
+			byLevel.resize(OB_STUDIO_OUTPUT_LEVELS);
+		}
+
+		OutputIndex::~OutputIndex(){}
+
+		void OutputIndex::clear(){
+			byTrigram.clear();
+			byLevel.clear();
+			byLevel.resize(OB_STUDIO_OUTPUT_LEVELS);
+		}
+
+		QVector<quint64> OutputIndex::trigrams(const QString& text){
+			QString folded = text.toCaseFolded();
+
+			QVector<quint64> grams;
+			if(folded.size() < 3){
+				return grams;
+			}
+
+			grams.reserve(folded.size() - 2);
+			for(int i = 0; i + 2 < folded.size(); i++){
+				grams.append(((quint64)folded[i].unicode() << 32) | ((quint64)folded[i + 1].unicode() << 16) | folded[i + 2].unicode());
+			}
+
+			std::sort(grams.begin(), grams.end());
+			grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+			return grams;
+		}
+
+		void OutputIndex::add(qint64 seq, const OutputRecord& rec){
+			QVector<quint64> grams = trigrams(rec.text);
+			for(int i = 0; i < grams.size(); i++){
+				byTrigram[grams[i]].lines.append(seq);
+			}
+			byLevel[(int)rec.level].lines.append(seq);
+		}
+
+		void OutputIndex::drop(qint64 seq, const OutputRecord& rec){
+			QVector<quint64> grams = trigrams(rec.text);
+			for(int i = 0; i < grams.size(); i++){
+				auto it = byTrigram.find(grams[i]);
+				if(it != byTrigram.end()){
+					it->dropThrough(seq);
+					if(it->size() == 0){
+						byTrigram.erase(it);
+					}
+				}
+			}
+			byLevel[(int)rec.level].dropThrough(seq);
+		}
+
+		bool OutputIndex::linesContaining(const QString& text, QVector<qint64>* lines) const{
+			QVector<quint64> grams = trigrams(text);
+			if(grams.isEmpty()){
+				return false;
+			}
+
+			// Every trigram of text has to be on the line
+			std::vector<const Postings*> lists;
+			for(int i = 0; i < grams.size(); i++){
+				auto it = byTrigram.constFind(grams[i]);
+				if(it == byTrigram.constEnd()){
+					return true;
+				}
+				lists.push_back(&it.value());
+			}
+			std::sort(lists.begin(), lists.end(), [](const Postings* a, const Postings* b){
+				return a->size() < b->size();
+			});
+
+			const Postings* rarest = lists[0];
+			for(int i = rarest->head; i < rarest->lines.size(); i++){
+				qint64 seq = rarest->lines[i];
+
+				bool onAll = true;
+				for(size_t j = 1; j < lists.size() && onAll; j++){
+					onAll = lists[j]->contains(seq);
+				}
+				if(onAll){
+					lines->append(seq);
+				}
+			}
+
+			return true;
+		}
+
+		void OutputIndex::linesWithLevels(int levels, QVector<qint64>* lines) const{
+			for(int l = 0; l < OB_STUDIO_OUTPUT_LEVELS; l++){
+				if(!(levels & (1 << l))){
+					continue;
+				}
+
+				const Postings& p = byLevel[l];
+				int before = lines->size();
+				for(int i = p.head; i < p.lines.size(); i++){
+					lines->append(p.lines[i]);
+				}
+				std::inplace_merge(lines->begin(), lines->begin() + before, lines->end());
+			}
+		}
+	}
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OB_STUDIO_OUTPUTINDEX_H_
+#define OB_STUDIO_OUTPUTINDEX_H_
+
+#include <QString>
+#include <QHash>
+#include <QVector>
+
+namespace OB{
+	namespace Studio{
+		struct OutputRecord;
+
+		/*
+		 * Index over an OutputLog's lines, kept up to date as lines
+		 * are added and dropped rather than rebuilt per search.
+		 *
+		 * Each line is posted under every distinct trigram of its
+		 * case-folded text and under its level. Postings are in line
+		 * order, so dropping the oldest lines only moves the front of
+		 * each list along. A search looks up the rarest trigram of
+		 * the text it needs and only those lines are tested.
+		 */
+		class OutputIndex{
+		public:
+			OutputIndex();
+			virtual ~OutputIndex();
+
+			void clear();
+
+			// Lines must be added oldest first, and dropped oldest
+			// first too
+			void add(qint64 seq, const OutputRecord& rec);
+			void drop(qint64 seq, const OutputRecord& rec);
+
+			// Lines that might contain text, ignoring case, in order.
+			// False if text is too short to narrow anything down.
+			bool linesContaining(const QString& text, QVector<qint64>* lines) const;
+
+			// Lines with a level in the mask of 1 << OutputLevel
+			void linesWithLevels(int levels, QVector<qint64>* lines) const;
+
+		private:
+			struct Postings{
+				QVector<qint64> lines;
+				int head;
+
+				Postings();
+
+				int size() const;
+				void dropThrough(qint64 seq);
+				bool contains(qint64 seq) const;
+			};
+
+			static QVector<quint64> trigrams(const QString& text);
+
+			QHash<quint64, Postings> byTrigram;
+			QVector<Postings> byLevel;
+		};
+	}
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// End:
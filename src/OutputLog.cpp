@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "OutputLog.h"
+
+#include <QDateTime>
+
+namespace OB{
+	namespace Studio{
+		OutputLog::OutputLog(){
+			ring.resize(OB_STUDIO_DEFAULT_OUTPUT_LINES);
+			start = 0;
+			count = 0;
+			firstSeq = 0;
+			lastChanged = false;
+
+			rateLimit = OB_STUDIO_DEFAULT_OUTPUT_RATE;
+			for(int i = 0; i < OB_STUDIO_OUTPUT_LEVELS; i++){
+				rates[i].start = 0;
+				rates[i].lines = 0;
+				rates[i].suppressed = 0;
+			}
+		}
+
+		OutputLog::~OutputLog(){}
+
+		int OutputLog::rowCount(const QModelIndex& parent) const{
+			if(parent.isValid()){
+				return 0;
+			}
+			return count;
+		}
+
+		QVariant OutputLog::data(const QModelIndex& index, int role) const{
+			if(!index.isValid() || index.row() >= count){
+				return QVariant();
+			}
+
+			const OutputRecord& rec = recordAt(index.row());
+			switch(role){
+				case Qt::DisplayRole: {
+					if(rec.repeats > 1){
+						return QString("%1 \u00d7%2").arg(rec.text).arg(rec.repeats);
+					}
+					return rec.text;
+				}
+				case Qt::ForegroundRole: {
+					if(rec.color.isValid()){
+						return rec.color;
+					}
+					return QVariant();
+				}
+				case Qt::ToolTipRole: {
+					return QDateTime::fromMSecsSinceEpoch(rec.timestamp).toString("hh:mm:ss.zzz");
+				}
+			}
+
+			return QVariant();
+		}
+
+		void OutputLog::append(QString text, OutputLevel level, QColor color){
+			qint64 now = QDateTime::currentMSecsSinceEpoch();
+			uint msgHash = qHash(text, (uint)level);
+
+			QStringList lines = text.split('\n');
+
+			OutputRecord* last = lastRecord();
+			if(last && last->msgHash == msgHash && last->level == level && last->text == lines.last()){
+				last->repeats++;
+				last->timestamp = now;
+				if(pending.isEmpty()){
+					lastChanged = true;
+				}
+				return;
+			}
+
+			if(rateLimit > 0){
+				endRateWindows(now, true);
+
+				RateWindow& win = rates[(int)level];
+				if(win.lines >= rateLimit){
+					win.suppressed++;
+					return;
+				}
+				win.lines += lines.size();
+			}
+
+			OutputRecord rec;
+			rec.timestamp = now;
+			rec.level = level;
+			rec.color = color;
+			rec.msgHash = 0;
+			rec.repeats = 1;
+
+			for(int i = 0; i < lines.size(); i++){
+				rec.text = lines[i];
+				if(i == lines.size() - 1){
+					rec.msgHash = msgHash;
+				}
+				pending.append(rec);
+			}
+
+			// Anything past this would fall off before it was seen
+			int cap = ring.size();
+			if(pending.size() > cap * 2){
+				pending.remove(0, pending.size() - cap);
+			}
+		}
+
+		OutputRecord* OutputLog::lastRecord(){
+			if(!pending.isEmpty()){
+				return &pending.last();
+			}
+			if(count > 0){
+				return &ring[(start + count - 1) % ring.size()];
+			}
+			return NULL;
+		}
+
+		void OutputLog::endRateWindows(qint64 now, bool expiredOnly){
+			for(int i = 0; i < OB_STUDIO_OUTPUT_LEVELS; i++){
+				RateWindow& win = rates[i];
+				if(expiredOnly && now - win.start < 1000){
+					continue;
+				}
+
+				if(win.suppressed > 0){
+					OutputRecord rec;
+					rec.timestamp = now;
+					rec.level = (OutputLevel)i;
+					rec.color = QColor(128, 128, 128);
+					rec.text = QString("%1 messages suppressed").arg(win.suppressed);
+					rec.msgHash = 0;
+					rec.repeats = 1;
+					pending.append(rec);
+				}
+
+				win.start = now;
+				win.lines = 0;
+				win.suppressed = 0;
+			}
+		}
+
+		bool OutputLog::flush(){
+			// A quiet script still gets its suppressed count shown
+			if(rateLimit > 0){
+				endRateWindows(QDateTime::currentMSecsSinceEpoch(), true);
+			}
+
+			// A repeat was folded into a line the view already has
+			if(lastChanged){
+				lastChanged = false;
+				if(count > 0){
+					QModelIndex idx = index(count - 1);
+					emit dataChanged(idx, idx);
+				}
+			}
+
+			if(pending.isEmpty()){
+				return false;
+			}
+
+			int cap = ring.size();
+
+			if(pending.size() > cap){
+				pending.remove(0, pending.size() - cap);
+			}
+			int n = pending.size();
+
+			int overflow = count + n - cap;
+			if(overflow > 0){
+				beginRemoveRows(QModelIndex(), 0, overflow - 1);
+				for(int i = 0; i < overflow; i++){
+					index.drop(firstSeq + i, recordAt(i));
+				}
+				start = (start + overflow) % cap;
+				count -= overflow;
+				firstSeq += overflow;
+				endRemoveRows();
+			}
+
+			beginInsertRows(QModelIndex(), count, count + n - 1);
+			for(int i = 0; i < n; i++){
+				ring[(start + count + i) % cap] = pending[i];
+				index.add(firstSeq + count + i, pending[i]);
+			}
+			count += n;
+			endInsertRows();
+
+			pending.clear();
+			return true;
+		}
+
+		const OutputRecord& OutputLog::recordAt(int row) const{
+			return ring[(start + row) % ring.size()];
+		}
+
+		qint64 OutputLog::getFirstSequence() const{
+			return firstSeq;
+		}
+
+		const OutputIndex& OutputLog::getIndex() const{
+			return index;
+		}
+
+		void OutputLog::reindex(){
+			index.clear();
+			for(int i = 0; i < count; i++){
+				index.add(firstSeq + i, recordAt(i));
+			}
+		}
+
+		int OutputLog::getCapacity(){
+			return ring.size();
+		}
+
+		void OutputLog::setCapacity(int capacity){
+			capacity = qMax(1, capacity);
+			if(capacity == ring.size()){
+				return;
+			}
+
+			beginResetModel();
+
+			// Keep the newest lines that still fit
+			int keep = qMin(count, capacity);
+			QVector<OutputRecord> newRing(capacity);
+			for(int i = 0; i < keep; i++){
+				newRing[i] = recordAt(count - keep + i);
+			}
+			ring.swap(newRing);
+			start = 0;
+			firstSeq += count - keep;
+			count = keep;
+			reindex();
+
+			endResetModel();
+		}
+
+		int OutputLog::getRateLimit(){
+			return rateLimit;
+		}
+
+		void OutputLog::setRateLimit(int perSecond){
+			if(rateLimit > 0){
+				endRateWindows(QDateTime::currentMSecsSinceEpoch(), false);
+			}
+			rateLimit = qMax(0, perSecond);
+		}
+
+		void OutputLog::clear(){
+			beginResetModel();
+			start = 0;
+			firstSeq += count;
+			count = 0;
+			for(int i = 0; i < ring.size(); i++){
+				ring[i] = OutputRecord();
+			}
+			pending.clear();
+			lastChanged = false;
+			index.clear();
+			endResetModel();
+		}
+	}
+}
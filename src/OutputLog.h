@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OB_STUDIO_OUTPUTLOG_H_
+#define OB_STUDIO_OUTPUTLOG_H_
+
+#include <QAbstractListModel>
+#include <QColor>
+#include <QVector>
+
+#include "OutputIndex.h"
+
+#define OB_STUDIO_DEFAULT_OUTPUT_LINES 10000
+#define OB_STUDIO_DEFAULT_OUTPUT_RATE 500
+
+namespace OB{
+	namespace Studio{
+		enum class OutputLevel{
+			Info,
+			Warning,
+			Error
+		};
+
+		#define OB_STUDIO_OUTPUT_LEVELS 3
+
+		struct OutputRecord{
+			qint64 timestamp;
+			OutputLevel level;
+			QColor color;
+			QString text;
+
+			// Set on the last line of a message, so a repeat of the
+			// whole message can be folded into it
+			uint msgHash;
+			int repeats;
+		};
+
+		/*
+		 * A tab's output, one row per line.
+		 *
+		 * Lines are kept in a ring buffer of a fixed number of
+		 * records, so the oldest fall off the top instead of the log
+		 * growing for the whole session. Appends are held until
+		 * flush(), which is called once per frame, so the view sees
+		 * one insert per frame no matter how much a script prints.
+		 *
+		 * A message identical to the one before it only bumps that
+		 * one's repeat count. Past the rate limit, a level's messages
+		 * are dropped for the rest of that second and replaced with
+		 * a count of how many were.
+		 *
+		 * An OutputIndex follows the lines as they come and go, so
+		 * searching the log never has to read all of it.
+		 */
+		class OutputLog: public QAbstractListModel{
+		public:
+			OutputLog();
+			virtual ~OutputLog();
+
+			virtual int rowCount(const QModelIndex& parent = QModelIndex()) const;
+			virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+
+			// Multi-line messages become one record per line
+			void append(QString text, OutputLevel level = OutputLevel::Info, QColor color = QColor());
+			bool flush();
+
+			const OutputRecord& recordAt(int row) const;
+
+			// Every line ever added gets the next number, row 0 is
+			// this one. Lets others follow lines as old ones drop off.
+			qint64 getFirstSequence() const;
+
+			const OutputIndex& getIndex() const;
+
+			int getCapacity();
+			void setCapacity(int capacity);
+
+			// Lines per second per level, 0 for no limit
+			int getRateLimit();
+			void setRateLimit(int perSecond);
+
+			void clear();
+
+		private:
+			QVector<OutputRecord> ring;
+			int start;
+			int count;
+			qint64 firstSeq;
+
+			OutputIndex index;
+			void reindex();
+
+			QVector<OutputRecord> pending;
+			bool lastChanged;
+
+			OutputRecord* lastRecord();
+			void endRateWindows(qint64 now, bool expiredOnly);
+
+			int rateLimit;
+			struct RateWindow{
+				qint64 start;
+				int lines;
+				int suppressed;
+			};
+			RateWindow rates[OB_STUDIO_OUTPUT_LEVELS];
+		};
+	}
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// End:
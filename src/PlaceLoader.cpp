@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "PlaceLoader.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QByteArray>
+
+#include <OBSerializer.h>
+
+#include "BinaryPlace.h"
+#include "AutosaveJournal.h"
+
+namespace OB{
+	namespace Studio{
+		PlaceLoader::PlaceLoader(QString fileName, OBEngine* eng, QMutex* engineLock) : PlaceTask(fileName, eng, engineLock){
+			setCancelable(true);
+		}
+
+		PlaceLoader::~PlaceLoader(){
+			cancel();
+			wait();
+		}
+
+		bool PlaceLoader::isRecovery(){
+			return QFileInfo(fileName).isDir();
+		}
+
+		void PlaceLoader::run(){
+			if(isRecovery()){
+				setCancelable(false);
+				setProgress(-1);
+
+				QString recoverError;
+
+				engineLock->lock();
+				bool recovered = AutosaveJournal::recover(eng, fileName, &recoverError);
+				engineLock->unlock();
+
+				if(!recovered){
+					fail(recoverError);
+					return;
+				}
+
+				setProgress(100);
+				finish(State::Done);
+				return;
+			}
+
+			QFile f(fileName);
+			if(!f.open(QFile::ReadOnly)){
+				fail("Failed to open file (can't read?)");
+				return;
+			}
+
+			qint64 fileSize = f.size();
+
+			// Map the file and hand the serializer the pages directly.
+			// The mapping is private, so if the serializer parses in
+			// place the file is left alone.
+			char* data = NULL;
+			uchar* mapped = NULL;
+			if(fileSize > 0){
+				mapped = f.map(0, fileSize, QFileDevice::MapPrivateOption);
+			}
+
+			// Some files can't be mapped (pipes, some network
+			// filesystems), read those into a single buffer
+			QByteArray buf;
+			if(mapped){
+				data = (char*)mapped;
+			}else{
+				buf.resize(fileSize);
+
+				qint64 bytesRead = 0;
+				while(bytesRead < fileSize){
+					if(isCancelRequested()){
+						finish(State::Canceled);
+						return;
+					}
+
+					qint64 toRead = qMin((qint64)OB_STUDIO_PLACE_CHUNK_SIZE, fileSize - bytesRead);
+					qint64 didRead = f.read(buf.data() + bytesRead, toRead);
+					if(didRead <= 0){
+						fail("Failed to read file.");
+						return;
+					}
+					bytesRead += didRead;
+
+					setProgress((int)((bytesRead * 100) / fileSize));
+				}
+
+				data = buf.data();
+			}
+
+			if(isCancelRequested()){
+				finish(State::Canceled);
+				return;
+			}
+
+			shared_ptr<OBSerializer> serializer = eng->getSerializer();
+			if(!serializer){
+				// This should never happen
+				fail("No serialization support.");
+				return;
+			}
+
+			setCancelable(false);
+			setProgress(-1);
+
+			QString loadError;
+			bool loaded = true;
+
+			engineLock->lock();
+			if(BinaryPlace::isBinary(data, fileSize)){
+				loaded = BinaryPlace::load(eng, data, fileSize, &loadError);
+			}else{
+				serializer->LoadFromMemory(data, fileSize);
+			}
+			engineLock->unlock();
+
+			if(mapped){
+				f.unmap(mapped);
+			}
+			f.close();
+
+			if(!loaded){
+				fail(loadError);
+				return;
+			}
+
+			setProgress(100);
+			finish(State::Done);
+		}
+	}
+}
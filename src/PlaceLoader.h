@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OB_STUDIO_PLACELOADER_H_
+#define OB_STUDIO_PLACELOADER_H_
+
+#include "PlaceTask.h"
+
+#define OB_STUDIO_LOAD_PUBLISH_BATCH 500
+
+namespace OB{
+	namespace Studio{
+		/*
+		 * Loads a place file into an engine. The file is memory
+		 * mapped, or read in chunks if it can't be, and handed to the
+		 * engine's serializer, or BinaryPlace for binary places.
+		 * Instances created by the serializer reach the GUI through
+		 * the tab's UI queue.
+		 *
+		 * Given an autosave directory instead of a file, the game is
+		 * recovered from its journal.
+		 *
+		 * Canceling is only honored until the serializer starts.
+		 */
+		class PlaceLoader: public PlaceTask{
+		public:
+			PlaceLoader(QString fileName, OBEngine* eng, QMutex* engineLock);
+			virtual ~PlaceLoader();
+
+			bool isRecovery();
+
+		protected:
+			virtual void run();
+		};
+	}
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// End:
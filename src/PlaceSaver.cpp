@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "PlaceSaver.h"
+
+#include <QSaveFile>
+#include <QFileInfo>
+
+#include "BinaryPlace.h"
+
+#include <OBSerializer.h>
+
+namespace OB{
+	namespace Studio{
+		PlaceSaver::PlaceSaver(QString fileName, OBEngine* eng, QMutex* engineLock, bool autosave) : PlaceTask(fileName, eng, engineLock){
+			this->autosave = autosave;
+		}
+
+		PlaceSaver::~PlaceSaver(){
+			wait();
+		}
+
+		bool PlaceSaver::isAutosave(){
+			return autosave;
+		}
+
+		const std::vector<BinaryPlace::SavedInstance>& PlaceSaver::getSaved(){
+			return saved;
+		}
+
+		void PlaceSaver::run(){
+			setProgress(-1);
+
+			engineLock->lock();
+
+			shared_ptr<OBSerializer> serializer = eng->getSerializer();
+			if(!serializer){
+				engineLock->unlock();
+				// This should never happen
+				fail("No serialization support.");
+				return;
+			}
+
+			std::string strToWrite;
+			QByteArray binToWrite;
+			QString binError;
+			bool binary = QFileInfo(fileName).suffix() == OB_STUDIO_BINARY_PLACE_SUFFIX;
+			bool serialized;
+			if(binary){
+				serialized = BinaryPlace::save(eng, true, &binToWrite, &binError, autosave ? &saved : NULL);
+			}else{
+				strToWrite = serializer->SaveInMemory_XML();
+				serialized = strToWrite.length() > 0;
+			}
+
+			// Snapshots are recovered by referent, files the tab has
+			// open by walking them once they're loaded
+			if(serialized && !autosave){
+				BinaryPlace::walkGame(eng, &saved);
+			}
+
+			engineLock->unlock();
+			releaseEngine();
+
+			if(!serialized){
+				fail(binError.isEmpty() ? QString("Failed to serialize game.") : binError);
+				return;
+			}
+
+			const char* data = binary ? binToWrite.constData() : strToWrite.data();
+			qint64 fileSize = binary ? binToWrite.size() : strToWrite.length();
+
+			setCancelable(true);
+
+			// Writes go to a temporary file which replaces the old one
+			// on commit(), so a crash never leaves it half written.
+			// Locations that can't hold a temporary file next to the
+			// target aren't written at all.
+			QSaveFile file(fileName);
+			if(!file.open(QIODevice::WriteOnly)){
+				fail("Failed to open file: couldn't create a temporary file next to " + QFileInfo(fileName).fileName() + " (" + file.errorString() + ")");
+				return;
+			}
+
+			qint64 written = 0;
+			setProgress(0);
+
+			while(written < fileSize){
+				if(isCancelRequested()){
+					file.cancelWriting();
+					finish(State::Canceled);
+					return;
+				}
+
+				qint64 toWrite = qMin((qint64)OB_STUDIO_PLACE_CHUNK_SIZE, fileSize - written);
+				qint64 didWrite = file.write(data + written, toWrite);
+				if(didWrite <= 0){
+					file.cancelWriting();
+					fail("Failed to write file");
+					return;
+				}
+				written += didWrite;
+
+				setProgress((int)((written * 100) / fileSize));
+			}
+
+			setCancelable(false);
+
+			if(!file.commit()){
+				fail("Failed to write file");
+				return;
+			}
+
+			finish(State::Done);
+		}
+	}
+}
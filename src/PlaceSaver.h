@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OB_STUDIO_PLACESAVER_H_
+#define OB_STUDIO_PLACESAVER_H_
+
+#include "PlaceTask.h"
+#include "BinaryPlace.h"
+
+namespace OB{
+	namespace Studio{
+		/*
+		 * Saves an engine's place to a file. The place is serialized
+		 * under engineLock, after which the engine is released and
+		 * the result is written through a QSaveFile, so the old file
+		 * is only replaced once the new one is complete. Files named
+		 * *.obgb are saved in the binary format, others as XML.
+		 * Autosave snapshots are savers too, they just don't change
+		 * which file the tab has open.
+		 *
+		 * What was saved is kept for the autosave journal to start
+		 * from: in referent order for snapshots, otherwise as
+		 * BinaryPlace::walkGame() would find it after loading.
+		 *
+		 * Canceling is only honored once the serializer is done.
+		 */
+		class PlaceSaver: public PlaceTask{
+		public:
+			PlaceSaver(QString fileName, OBEngine* eng, QMutex* engineLock, bool autosave = false);
+			virtual ~PlaceSaver();
+
+			bool isAutosave();
+			const std::vector<BinaryPlace::SavedInstance>& getSaved();
+
+		protected:
+			virtual void run();
+
+		private:
+			bool autosave;
+			std::vector<BinaryPlace::SavedInstance> saved;
+		};
+	}
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "PlaceTask.h"
+
+namespace OB{
+	namespace Studio{
+		PlaceTask::PlaceTask(QString fileName, OBEngine* eng, QMutex* engineLock) : QThread(NULL){
+			this->fileName = fileName;
+			this->eng = eng;
+			this->engineLock = engineLock;
+
+			state = (int)State::Running;
+			progress = 0;
+			cancelRequested = false;
+			cancelable = false;
+			engineOwned = true;
+		}
+
+		PlaceTask::~PlaceTask(){
+			wait();
+		}
+
+		QString PlaceTask::getFileName(){
+			return fileName;
+		}
+
+		PlaceTask::State PlaceTask::getState(){
+			return (State)state.load();
+		}
+
+		bool PlaceTask::isDone(){
+			return getState() != State::Running;
+		}
+
+		int PlaceTask::getProgress(){
+			return progress;
+		}
+
+		QString PlaceTask::getError(){
+			if(getState() != State::Failed){
+				return QString();
+			}
+			return error;
+		}
+
+		bool PlaceTask::ownsEngine(){
+			return engineOwned;
+		}
+
+		void PlaceTask::cancel(){
+			cancelRequested = true;
+		}
+
+		bool PlaceTask::canCancel(){
+			return cancelable && !isDone();
+		}
+
+		void PlaceTask::setProgress(int progress){
+			this->progress = progress;
+		}
+
+		void PlaceTask::setCancelable(bool cancelable){
+			this->cancelable = cancelable;
+		}
+
+		void PlaceTask::releaseEngine(){
+			engineOwned = false;
+		}
+
+		bool PlaceTask::isCancelRequested(){
+			return cancelRequested;
+		}
+
+		void PlaceTask::fail(QString error){
+			this->error = error;
+			finish(State::Failed);
+		}
+
+		void PlaceTask::finish(State state){
+			engineOwned = false;
+			this->state = (int)state;
+		}
+	}
+}
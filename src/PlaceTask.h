@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OB_STUDIO_PLACETASK_H_
+#define OB_STUDIO_PLACETASK_H_
+
+#include <QThread>
+#include <QMutex>
+#include <QString>
+
+#include <OBEngine.h>
+
+#include <atomic>
+
+#define OB_STUDIO_PLACE_CHUNK_SIZE (1024 * 1024)
+
+namespace OB{
+	namespace Studio{
+		/*
+		 * Base for moving a place between an engine and a file off
+		 * the GUI thread. The task only touches the engine while
+		 * holding engineLock, and until ownsEngine() goes false the
+		 * GUI thread must not block on that lock.
+		 */
+		class PlaceTask: public QThread{
+		public:
+			enum class State{
+				Running,
+				Done,
+				Failed,
+				Canceled
+			};
+
+			PlaceTask(QString fileName, OBEngine* eng, QMutex* engineLock);
+			virtual ~PlaceTask();
+
+			QString getFileName();
+			State getState();
+			bool isDone();
+
+			// 0-100, or -1 when there's no way to tell
+			int getProgress();
+			QString getError();
+
+			bool ownsEngine();
+
+			void cancel();
+			bool canCancel();
+
+		protected:
+			void setProgress(int progress);
+			void setCancelable(bool cancelable);
+			void releaseEngine();
+			bool isCancelRequested();
+
+			void fail(QString error);
+			void finish(State state);
+
+			QString fileName;
+			OBEngine* eng;
+			QMutex* engineLock;
+
+		private:
+			std::atomic<int> state;
+			std::atomic<int> progress;
+			std::atomic<bool> cancelRequested;
+			std::atomic<bool> cancelable;
+			std::atomic<bool> engineOwned;
+
+			// Only written before state becomes Failed
+			QString error;
+		};
+	}
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// End:
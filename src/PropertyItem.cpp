@@ -37,8 +37,8 @@ namespace OB{
 	namespace Studio{
 		PropertyItem::PropertyItem(PropertyTreeWidget* tree, QString name){
 			this->tree = tree;
-			propertyName = name.toStdString();
-			propertyType = "unknown";
+			propertyId = PropertyNames::intern(name.toStdString());
+			propertyType = PropertyType::Unknown;
 
 			setText(0, name);
 			setFlags(Qt::ItemIsEnabled | Qt::ItemIsEditable);
@@ -47,15 +47,19 @@ namespace OB{
 
 		PropertyItem::~PropertyItem(){}
 
+		PropertyId PropertyItem::getPropertyId(){
+			return propertyId;
+		}
+
 		std::string PropertyItem::getPropertyName(){
-			return propertyName;
+			return PropertyNames::name(propertyId);
 		}
 
-		std::string PropertyItem::getPropertyType(){
+		PropertyType PropertyItem::getPropertyType(){
 			return propertyType;
 		}
 
-		void PropertyItem::setPropertyType(std::string type){
+		void PropertyItem::setPropertyType(PropertyType type){
 			propertyType = type;
 		}
 
@@ -88,7 +92,7 @@ namespace OB{
 		// StringPropertyItem
 
 		StringPropertyItem::StringPropertyItem(PropertyTreeWidget* tree, QString name) : PropertyItem(tree, name){
-			setPropertyType("string");
+			setPropertyType(PropertyType::String);
 			val = "";
 			setText(1, "");
 		}
@@ -136,14 +140,14 @@ namespace OB{
 			if(lineEdit){
 				setTextValue(lineEdit->text());
 
-				tree->setProp(propertyName, getValue());
+				tree->setProp(propertyId, getValue());
 			}
 		}
 
 		// InstancePropertyItem
 
 		InstancePropertyItem::InstancePropertyItem(PropertyTreeWidget* tree, QString name) : PropertyItem(tree, name){
-			setPropertyType("Instance");
+			setPropertyType(PropertyType::Instance);
 			val = NULL;
 			setText(1, "");
 
@@ -205,7 +209,7 @@ namespace OB{
 		}
 
 		BoolPropertyItem::BoolPropertyItem(PropertyTreeWidget* tree, QString name) : PropertyItem(tree, name){
-			setPropertyType("bool");
+			setPropertyType(PropertyType::Bool);
 			val = false;
 			setIcon(1, getCheckBox(val, flags() & Qt::ItemIsEnabled));
 		}
@@ -243,7 +247,7 @@ namespace OB{
 					val = !val;
 					setIcon(1, getCheckBox(this->val, !(flags() & Qt::ItemIsEnabled)));
 
-					tree->setProp(propertyName, getValue());
+					tree->setProp(propertyId, getValue());
 
 					return true;
 				}
@@ -255,7 +259,7 @@ namespace OB{
 		// IntPropertyItem
 
 		IntPropertyItem::IntPropertyItem(PropertyTreeWidget* tree, QString name) : PropertyItem(tree, name){
-			setPropertyType("int");
+			setPropertyType(PropertyType::Int);
 			val = 0;
 			setText(1, getTextValue());
 		}
@@ -302,14 +306,14 @@ namespace OB{
 				val = spinBox->value();
 				setText(1, getTextValue());
 
-				tree->setProp(propertyName, getValue());
+				tree->setProp(propertyId, getValue());
 			}
 		}
 
 		// DoublePropertyItem
 
 		DoublePropertyItem::DoublePropertyItem(PropertyTreeWidget* tree, QString name) : PropertyItem(tree, name){
-			setPropertyType("double");
+			setPropertyType(PropertyType::Double);
 			val = 0;
 			setText(1, getTextValue());
 		}
@@ -356,14 +360,14 @@ namespace OB{
 				val = spinBox->value();
 				setText(1, getTextValue());
 
-				tree->setProp(propertyName, getValue());
+				tree->setProp(propertyId, getValue());
 			}
 		}
 
 		// FloatPropertyItem
 
 		FloatPropertyItem::FloatPropertyItem(PropertyTreeWidget* tree, QString name) : PropertyItem(tree, name){
-			setPropertyType("float");
+			setPropertyType(PropertyType::Float);
 			val = 0;
 			setText(1, getTextValue());
 		}
@@ -410,7 +414,7 @@ namespace OB{
 				val = (float)spinBox->value();
 				setText(1, getTextValue());
 
-				tree->setProp(propertyName, getValue());
+				tree->setProp(propertyId, getValue());
 			}
 		}
 
@@ -431,7 +435,7 @@ namespace OB{
 		}
 
 		Color3PropertyItem::Color3PropertyItem(PropertyTreeWidget* tree, QString name) : PropertyItem(tree, name){
-			setPropertyType("Color3");
+			setPropertyType(PropertyType::Color3);
 			val = make_shared<Type::Color3>();
 			setIcon(1, getColorAsIcon(QColor(0, 0, 0)));
 			setText(1, getTextValue());
@@ -478,7 +482,7 @@ namespace OB{
 					val = make_shared<Type::Color3>(col.red(), col.green(), col.blue());
 					setText(1, getTextValue());
 
-					tree->setProp(propertyName, getValue());
+					tree->setProp(propertyId, getValue());
 				}
 			}
 		}
@@ -486,7 +490,7 @@ namespace OB{
 		// ChildDoublePropertyItem
 
 		ChildDoublePropertyItem::ChildDoublePropertyItem(PropertyTreeWidget* tree, QString name) : PropertyItem(tree, name){
-			setPropertyType("double");
+			setPropertyType(PropertyType::Double);
 			val = 0;
 			setText(1, getTextValue());
 		}
@@ -538,7 +542,7 @@ namespace OB{
 		// Vector3PropertyItem
 
 		Vector3PropertyItem::Vector3PropertyItem(PropertyTreeWidget* tree, QString name) : PropertyItem(tree, name){
-			setPropertyType("Vector3");
+			setPropertyType(PropertyType::Vector3);
 			val = make_shared<Type::Vector3>();
 			setText(1, getTextValue());
 
@@ -650,7 +654,7 @@ namespace OB{
 			if(lineEdit){
 				setTextValue(lineEdit->text());
 
-				tree->setProp(propertyName, getValue());
+				tree->setProp(propertyId, getValue());
 			}
 		}
 
@@ -662,13 +666,13 @@ namespace OB{
 			val = make_shared<Type::Vector3>(xval, yval, zval);
 			setText(1, getTextValue());
 
-			tree->setProp(propertyName, getValue());
+			tree->setProp(propertyId, getValue());
 		}
 
 		// Vector2PropertyItem
 
 		Vector2PropertyItem::Vector2PropertyItem(PropertyTreeWidget* tree, QString name) : PropertyItem(tree, name){
-			setPropertyType("Vector2");
+			setPropertyType(PropertyType::Vector2);
 			val = make_shared<Type::Vector2>();
 			setText(1, getTextValue());
 
@@ -765,7 +769,7 @@ namespace OB{
 			if(lineEdit){
 				setTextValue(lineEdit->text());
 
-				tree->setProp(propertyName, getValue());
+				tree->setProp(propertyId, getValue());
 			}
 		}
 
@@ -776,13 +780,13 @@ namespace OB{
 			val = make_shared<Type::Vector2>(xval, yval);
 			setText(1, getTextValue());
 
-			tree->setProp(propertyName, getValue());
+			tree->setProp(propertyId, getValue());
 		}
 
 		// UDimPropertyItem
 
 		UDimPropertyItem::UDimPropertyItem(PropertyTreeWidget* tree, QString name) : PropertyItem(tree, name){
-			setPropertyType("UDim");
+			setPropertyType(PropertyType::UDim);
 			val = make_shared<Type::UDim>();
 			setText(1, getTextValue());
 
@@ -879,7 +883,7 @@ namespace OB{
 			if(lineEdit){
 				setTextValue(lineEdit->text());
 
-				tree->setProp(propertyName, getValue());
+				tree->setProp(propertyId, getValue());
 			}
 		}
 
@@ -890,13 +894,13 @@ namespace OB{
 			val = make_shared<Type::UDim>(scaleval, offsetval);
 			setText(1, getTextValue());
 
-			tree->setProp(propertyName, getValue());
+			tree->setProp(propertyId, getValue());
 		}
 
 		// UDim2PropertyItem
 
 		UDim2PropertyItem::UDim2PropertyItem(PropertyTreeWidget* tree, QString name) : PropertyItem(tree, name){
-			setPropertyType("UDim2");
+			setPropertyType(PropertyType::UDim2);
 			val = make_shared<Type::UDim2>();
 			setText(1, getTextValue());
 
@@ -1031,7 +1035,7 @@ namespace OB{
 			if(lineEdit){
 				setTextValue(lineEdit->text());
 
-				tree->setProp(propertyName, getValue());
+				tree->setProp(propertyId, getValue());
 			}
 		}
 
@@ -1044,7 +1048,7 @@ namespace OB{
 			val = make_shared<Type::UDim2>(xscaleval, xoffsetval, yscaleval, yoffsetval);
 			setText(1, getTextValue());
 
-			tree->setProp(propertyName, getValue());
+			tree->setProp(propertyId, getValue());
 		}
 	}
 }
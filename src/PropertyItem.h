@@ -36,9 +36,10 @@ namespace OB{
 			PropertyItem(PropertyTreeWidget* tree, QString name);
 			virtual ~PropertyItem();
 
+			PropertyId getPropertyId();
 			std::string getPropertyName();
-			std::string getPropertyType();
-			void setPropertyType(std::string type);
+			PropertyType getPropertyType();
+			void setPropertyType(PropertyType type);
 
 			virtual shared_ptr<Type::VarWrapper> getValue();
 			virtual void setValue(shared_ptr<Type::VarWrapper> val);
@@ -54,8 +55,8 @@ namespace OB{
 
 			PropertyTreeWidget* tree;
 
-			std::string propertyName;
-			std::string propertyType;
+			PropertyId propertyId;
+			PropertyType propertyType;
 		};
 
 		class StringPropertyItem: public PropertyItem{
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "PropertySchema.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace OB{
+	namespace Studio{
+		static std::unordered_map<std::string, PropertyId>& ob_studio_property_ids(){
+			static std::unordered_map<std::string, PropertyId> ids;
+			return ids;
+		}
+
+		static std::vector<std::string>& ob_studio_property_names(){
+			static std::vector<std::string> names;
+			return names;
+		}
+
+		PropertyId PropertyNames::intern(const std::string& name){
+			std::unordered_map<std::string, PropertyId>& ids = ob_studio_property_ids();
+
+			auto it = ids.find(name);
+			if(it != ids.end()){
+				return it->second;
+			}
+
+			std::vector<std::string>& names = ob_studio_property_names();
+			PropertyId id = names.size();
+			names.push_back(name);
+			ids[name] = id;
+			return id;
+		}
+
+		bool PropertyNames::find(const std::string& name, PropertyId* id){
+			std::unordered_map<std::string, PropertyId>& ids = ob_studio_property_ids();
+
+			auto it = ids.find(name);
+			if(it == ids.end()){
+				return false;
+			}
+			*id = it->second;
+			return true;
+		}
+
+		const std::string& PropertyNames::name(PropertyId id){
+			return ob_studio_property_names().at(id);
+		}
+
+		PropertyType ob_studio_property_type(const std::string& type){
+			static const std::unordered_map<std::string, PropertyType> types = {
+				{"string", PropertyType::String},
+				{"bool", PropertyType::Bool},
+				{"int", PropertyType::Int},
+				{"double", PropertyType::Double},
+				{"float", PropertyType::Float},
+				{"Color3", PropertyType::Color3},
+				{"Vector3", PropertyType::Vector3},
+				{"Vector2", PropertyType::Vector2},
+				{"UDim", PropertyType::UDim},
+				{"UDim2", PropertyType::UDim2},
+				{"Instance", PropertyType::Instance}
+			};
+
+			auto it = types.find(type);
+			if(it != types.end()){
+				return it->second;
+			}
+			return PropertyType::Unknown;
+		}
+
+		// ClassSchema
+
+		static const char* ob_studio_protected_classes[] = {
+			"Workspace",
+			"Lighting",
+			"ContentProvider",
+			"LogService",
+			"RunService",
+			"ReplicatedFirst"
+		};
+
+		shared_ptr<const ClassSchema> ClassSchema::forInstance(shared_ptr<Instance::Instance> inst){
+			static std::unordered_map<std::string, shared_ptr<const ClassSchema>> schemaCache;
+
+			std::string className = inst->getClassName();
+
+			auto it = schemaCache.find(className);
+			if(it != schemaCache.end()){
+				return it->second;
+			}
+
+			shared_ptr<ClassSchema> schema = make_shared<ClassSchema>();
+
+			schema->protectedClass = false;
+			for(size_t i = 0; i < sizeof(ob_studio_protected_classes) / sizeof(ob_studio_protected_classes[0]); i++){
+				if(className == ob_studio_protected_classes[i]){
+					schema->protectedClass = true;
+					break;
+				}
+			}
+
+			std::map<std::string, Instance::_PropertyInfo> props = inst->getProperties();
+			for(auto pIt = props.begin(); pIt != props.end(); ++pIt){
+				if(pIt->second.isPublic){
+					PropertySchemaEntry entry;
+					entry.id = PropertyNames::intern(pIt->first);
+					entry.type = ob_studio_property_type(pIt->second.type);
+					entry.readOnly = pIt->second.readOnly;
+
+					if(entry.type != PropertyType::Unknown){
+						schema->props.push_back(entry);
+					}
+				}
+			}
+
+			std::sort(schema->props.begin(), schema->props.end(), [](const PropertySchemaEntry& a, const PropertySchemaEntry& b){
+				return a.id < b.id;
+			});
+
+			schemaCache[className] = schema;
+			return schema;
+		}
+
+		const std::vector<PropertySchemaEntry>& ClassSchema::entries() const{
+			return props;
+		}
+
+		bool ClassSchema::isProtected() const{
+			return protectedClass;
+		}
+
+		const PropertySchemaEntry* ClassSchema::find(PropertyId id) const{
+			auto it = std::lower_bound(props.begin(), props.end(), id, [](const PropertySchemaEntry& entry, PropertyId id){
+				return entry.id < id;
+			});
+			if(it != props.end() && it->id == id){
+				return &*it;
+			}
+			return NULL;
+		}
+	}
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OB_STUDIO_PROPERTYSCHEMA_H_
+#define OB_STUDIO_PROPERTYSCHEMA_H_
+
+#include <instance/Instance.h>
+
+#include <string>
+#include <vector>
+
+namespace OB{
+	namespace Studio{
+		/*
+		 * Property names are interned to small integers the first time
+		 * they're seen, so the property tree can key and compare them
+		 * without touching the strings. Ids are only valid on the GUI
+		 * thread and are never reused.
+		 */
+		typedef size_t PropertyId;
+
+		enum class PropertyType{
+			Unknown,
+			String,
+			Bool,
+			Int,
+			Double,
+			Float,
+			Color3,
+			Vector3,
+			Vector2,
+			UDim,
+			UDim2,
+			Instance,
+			Count
+		};
+
+		class PropertyNames{
+		public:
+			static PropertyId intern(const std::string& name);
+			static bool find(const std::string& name, PropertyId* id);
+			static const std::string& name(PropertyId id);
+		};
+
+		PropertyType ob_studio_property_type(const std::string& type);
+
+		struct PropertySchemaEntry{
+			PropertyId id;
+			PropertyType type;
+			bool readOnly;
+		};
+
+		/*
+		 * Public properties of one class, sorted by id, and whether
+		 * Studio should keep its hands off the class. Built once per
+		 * class name and shared by every instance of that class.
+		 */
+		class ClassSchema{
+		public:
+			static shared_ptr<const ClassSchema> forInstance(shared_ptr<Instance::Instance> inst);
+
+			const std::vector<PropertySchemaEntry>& entries() const;
+			const PropertySchemaEntry* find(PropertyId id) const;
+
+			// Core services that can't be duplicated, deleted or renamed
+			bool isProtected() const;
+
+		private:
+			std::vector<PropertySchemaEntry> props;
+			bool protectedClass;
+		};
+	}
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// End:
@@ -21,7 +21,7 @@
 
 #include <QtWidgets>
 
-#include <set>
+#include <unordered_set>
 
 #include "PropertyTreeWidget.h"
 #include "PropertyTreeItemDelegate.h"
@@ -64,182 +64,116 @@ namespace OB{
 
 		PropertyTreeWidget::~PropertyTreeWidget(){}
 
-		void PropertyTreeWidget::updateSelection(std::vector<shared_ptr<Instance::Instance>> selectedInstances){
-			editingInstances = selectedInstances;
+		template<class T> static PropertyItem* ob_studio_new_property_item(PropertyTreeWidget* tree, QString name){
+			return new T(tree, name);
+		}
 
-			if(!editingInstances.empty()){
-				std::set<std::string> sharedProperties;
-				std::map<std::string, Instance::_PropertyInfo> props = editingInstances[0]->getProperties();
+		struct PropertyItemFactory{
+			PropertyItem* (*create)(PropertyTreeWidget* tree, QString name);
+			bool honorReadOnly;
+		};
 
-				// Push names of all properties to sharedProperties
-				for(auto it = props.begin(); it != props.end(); ++it){
-					if(it->second.isPublic){
-						sharedProperties.insert(it->first);
-					}
-				}
+		// Indexed by PropertyType
+		static const PropertyItemFactory ob_studio_property_factories[] = {
+			{NULL, false},
+			{ob_studio_new_property_item<StringPropertyItem>, true},
+			{ob_studio_new_property_item<BoolPropertyItem>, true},
+			{ob_studio_new_property_item<IntPropertyItem>, true},
+			{ob_studio_new_property_item<DoublePropertyItem>, true},
+			{ob_studio_new_property_item<FloatPropertyItem>, true},
+			{ob_studio_new_property_item<Color3PropertyItem>, true},
+			{ob_studio_new_property_item<Vector3PropertyItem>, true},
+			{ob_studio_new_property_item<Vector2PropertyItem>, true},
+			{ob_studio_new_property_item<UDimPropertyItem>, true},
+			{ob_studio_new_property_item<UDim2PropertyItem>, true},
+			{ob_studio_new_property_item<InstancePropertyItem>, false}
+		};
 
-				// Remove properties not all instances have
+		static_assert(sizeof(ob_studio_property_factories) / sizeof(ob_studio_property_factories[0]) == (size_t)PropertyType::Count, "ob_studio_property_factories must cover every PropertyType");
+
+		void PropertyTreeWidget::updateSelection(SelectionSnapshot selectedInstances){
+			editingInstances = selectedInstances;
+
+			if(!editingInstances.empty()){
+				// Gather each distinct class once, a selection of 10k
+				// parts only has to look at one schema.
+				std::vector<shared_ptr<const ClassSchema>> schemas;
+				std::unordered_set<const ClassSchema*> seenSchemas;
 				for(auto i = editingInstances.begin(); i != editingInstances.end(); ++i){
 					shared_ptr<Instance::Instance> inst = *i;
 					if(inst){
-						std::map<std::string, Instance::_PropertyInfo> tprops = inst->getProperties();
-
-						for(auto it = sharedProperties.begin(); it != sharedProperties.end();){
-							auto fIt = tprops.find(*it);
-							if(fIt == tprops.end()){
-								it = sharedProperties.erase(it);
-							}else{
-								Instance::_PropertyInfo pInfo = fIt->second;
-								if(!pInfo.isPublic){
-									it = sharedProperties.erase(it);
-								}else{
-									Instance::_PropertyInfo pInfoOrig = props[*it];
-									if(pInfoOrig.type != pInfo.type){
-										it = sharedProperties.erase(it);
-									}else{
-										++it;
-									}
-								}
-							}
+						shared_ptr<const ClassSchema> schema = ClassSchema::forInstance(inst);
+						if(seenSchemas.insert(schema.get()).second){
+							schemas.push_back(schema);
 						}
 					}
 				}
 
-				// Remove properties that aren't valid anymore
-				for(auto i = curProps.begin(); i != curProps.end();){
-					if(std::find(sharedProperties.begin(), sharedProperties.end(), i->first) == sharedProperties.end()){
-						invisibleRootItem()->removeChild(i->second);
-						delete i->second;
-						i = curProps.erase(i);
-					}else{
-						++i;
+				if(schemas.empty()){
+					updateSelection(SelectionSnapshot());
+					return;
+				}
+
+				// Entries are sorted by id, so the intersection is a merge
+				std::vector<PropertySchemaEntry> sharedProperties = schemas[0]->entries();
+				for(size_t i = 1; i < schemas.size() && !sharedProperties.empty(); i++){
+					const std::vector<PropertySchemaEntry>& tprops = schemas[i]->entries();
+
+					auto out = sharedProperties.begin();
+					auto tIt = tprops.begin();
+					for(auto it = sharedProperties.begin(); it != sharedProperties.end(); ++it){
+						while(tIt != tprops.end() && tIt->id < it->id){
+							++tIt;
+						}
+						if(tIt != tprops.end() && tIt->id == it->id && tIt->type == it->type){
+							*out++ = *it;
+						}
 					}
+					sharedProperties.erase(out, sharedProperties.end());
 				}
 
+				std::unordered_map<PropertyId, PropertyItem*> newProps;
+				newProps.reserve(sharedProperties.size());
+
 				for(auto it = sharedProperties.begin(); it != sharedProperties.end(); ++it){
-					std::string propName = *it;
+					const PropertySchemaEntry& pInfo = *it;
 
-					Instance::_PropertyInfo pInfo = props[propName];
+					auto oldIt = curProps.find(pInfo.id);
+					if(oldIt != curProps.end()){
+						PropertyItem* oldItem = oldIt->second;
+						curProps.erase(oldIt);
 
-					PropertyItem* oldItem = curProps[propName];
-					if(oldItem){
 						if(oldItem->getPropertyType() == pInfo.type){
-							updateValue(propName);
+							newProps[pInfo.id] = oldItem;
 							continue;
-						}else{
-							invisibleRootItem()->removeChild(oldItem);
-							curProps.erase(propName);
-							delete oldItem;
 						}
-					}
 
-					if(pInfo.type == "string"){
-						StringPropertyItem* pi = new StringPropertyItem(this, QString(propName.c_str()));
-						if(pInfo.readOnly){
-							pi->setFlags(pi->flags() & ~Qt::ItemIsEnabled);
-						}
-						curProps[propName] = pi;
-						addTopLevelItem(pi);
-						updateValue(propName);
-						continue;
-					}
-					if(pInfo.type == "bool"){
-						BoolPropertyItem* pi = new BoolPropertyItem(this, QString(propName.c_str()));
-						if(pInfo.readOnly){
-							pi->setFlags(pi->flags() & ~Qt::ItemIsEnabled);
-						}
-						curProps[propName] = pi;
-						addTopLevelItem(pi);
-						updateValue(propName);
-						continue;
-					}
-					if(pInfo.type == "int"){
-						IntPropertyItem* pi = new IntPropertyItem(this, QString(propName.c_str()));
-						if(pInfo.readOnly){
-							pi->setFlags(pi->flags() & ~Qt::ItemIsEnabled);
-						}
-						curProps[propName] = pi;
-						addTopLevelItem(pi);
-						updateValue(propName);
-						continue;
+						invisibleRootItem()->removeChild(oldItem);
+						delete oldItem;
 					}
-					if(pInfo.type == "double"){
-						DoublePropertyItem* pi = new DoublePropertyItem(this, QString(propName.c_str()));
-						if(pInfo.readOnly){
-							pi->setFlags(pi->flags() & ~Qt::ItemIsEnabled);
-						}
-						curProps[propName] = pi;
-						addTopLevelItem(pi);
-						updateValue(propName);
-						continue;
-					}
-					if(pInfo.type == "float"){
-						FloatPropertyItem* pi = new FloatPropertyItem(this, QString(propName.c_str()));
-						if(pInfo.readOnly){
-							pi->setFlags(pi->flags() & ~Qt::ItemIsEnabled);
-						}
-						curProps[propName] = pi;
-						addTopLevelItem(pi);
-						updateValue(propName);
-						continue;
-					}
-					if(pInfo.type == "Color3"){
-						Color3PropertyItem* pi = new Color3PropertyItem(this, QString(propName.c_str()));
-						if(pInfo.readOnly){
-							pi->setFlags(pi->flags() & ~Qt::ItemIsEnabled);
-						}
-						curProps[propName] = pi;
-						addTopLevelItem(pi);
-						updateValue(propName);
-						continue;
-					}
-					if(pInfo.type == "Vector3"){
-						Vector3PropertyItem* pi = new Vector3PropertyItem(this, QString(propName.c_str()));
-						if(pInfo.readOnly){
-							pi->setFlags(pi->flags() & ~Qt::ItemIsEnabled);
-						}
-						curProps[propName] = pi;
-						addTopLevelItem(pi);
-						updateValue(propName);
-						continue;
-					}
-					if(pInfo.type == "Vector2"){
-						Vector2PropertyItem* pi = new Vector2PropertyItem(this, QString(propName.c_str()));
-						if(pInfo.readOnly){
-							pi->setFlags(pi->flags() & ~Qt::ItemIsEnabled);
-						}
-						curProps[propName] = pi;
-						addTopLevelItem(pi);
-						updateValue(propName);
-						continue;
-					}
-					if(pInfo.type == "UDim"){
-						UDimPropertyItem* pi = new UDimPropertyItem(this, QString(propName.c_str()));
-						if(pInfo.readOnly){
-							pi->setFlags(pi->flags() & ~Qt::ItemIsEnabled);
-						}
-						curProps[propName] = pi;
-						addTopLevelItem(pi);
-						updateValue(propName);
-						continue;
-					}
-					if(pInfo.type == "UDim2"){
-						UDim2PropertyItem* pi = new UDim2PropertyItem(this, QString(propName.c_str()));
-						if(pInfo.readOnly){
-							pi->setFlags(pi->flags() & ~Qt::ItemIsEnabled);
-						}
-						curProps[propName] = pi;
-						addTopLevelItem(pi);
-						updateValue(propName);
+
+					const PropertyItemFactory& factory = ob_studio_property_factories[(size_t)pInfo.type];
+					if(!factory.create){
 						continue;
 					}
-					if(pInfo.type == "Instance"){
-						InstancePropertyItem* pi = new InstancePropertyItem(this, QString(propName.c_str()));
-						curProps[propName] = pi;
-						addTopLevelItem(pi);
-						updateValue(propName);
-						continue;
+
+					PropertyItem* pi = factory.create(this, QString(PropertyNames::name(pInfo.id).c_str()));
+					if(factory.honorReadOnly && pInfo.readOnly){
+						pi->setFlags(pi->flags() & ~Qt::ItemIsEnabled);
 					}
+					newProps[pInfo.id] = pi;
+					addTopLevelItem(pi);
+				}
+
+				// Anything left over isn't shared by the selection anymore
+				for(auto i = curProps.begin(); i != curProps.end(); ++i){
+					invisibleRootItem()->removeChild(i->second);
+					delete i->second;
+				}
+				curProps.swap(newProps);
+
+				for(auto it = sharedProperties.begin(); it != sharedProperties.end(); ++it){
+					updateValue(it->id);
 				}
 			}else{
 				for(auto i = curProps.begin(); i != curProps.end();){
@@ -251,8 +185,18 @@ namespace OB{
 		}
 
 		void PropertyTreeWidget::updateValue(std::string prop){
-			PropertyItem* propItem = curProps[prop];
-			if(propItem){
+			PropertyId id;
+			if(PropertyNames::find(prop, &id)){
+				updateValue(id);
+			}
+		}
+
+		void PropertyTreeWidget::updateValue(PropertyId prop){
+			auto it = curProps.find(prop);
+			if(it != curProps.end()){
+				PropertyItem* propItem = it->second;
+				const std::string& propName = PropertyNames::name(prop);
+
 				shared_ptr<Type::VarWrapper> toSet;
 				bool firstPass = true;
 				bool hasMultiple = false;
@@ -260,12 +204,12 @@ namespace OB{
 				for(auto i = editingInstances.begin(); i != editingInstances.end(); ++i){
 					shared_ptr<Instance::Instance> inst = *i;
 					if(inst){
-						shared_ptr<Type::VarWrapper> iVal = inst->getProperty(prop);
+						shared_ptr<Type::VarWrapper> iVal = inst->getProperty(propName);
 						if(firstPass){
 							toSet = iVal;
 							firstPass = false;
-						}else{
-							if(!iVal->valueEquals(toSet)){
+						}else if(iVal != toSet){
+							if(!iVal || !toSet || !iVal->valueEquals(toSet)){
 								hasMultiple = true;
 								break;
 							}
@@ -281,12 +225,27 @@ namespace OB{
 			}
 		}
 
-		void PropertyTreeWidget::setProp(std::string prop, shared_ptr<Type::VarWrapper> val){
+		void PropertyTreeWidget::setProp(PropertyId prop, shared_ptr<Type::VarWrapper> val){
+			const std::string& propName = PropertyNames::name(prop);
+
+			// Edits to the same property in quick succession, like
+			// stepping a spin box, are one undo step
+			UndoCommand* cmd = new UndoCommand("Change " + QString(propName.c_str()));
+			cmd->setMergeable(true);
+
+			StudioGLWidget* undoWidget = NULL;
+
 			for(auto i = editingInstances.begin(); i != editingInstances.end(); ++i){
 				shared_ptr<Instance::Instance> inst = *i;
 				if(inst){
 					try{
-						inst->setProperty(prop, val);
+						shared_ptr<Type::VarWrapper> oldVal = inst->getProperty(propName);
+						inst->setProperty(propName, val);
+						cmd->addPropertyChange(inst, prop, oldVal, val);
+
+						if(!undoWidget){
+							undoWidget = StudioWindow::static_win->getCurrentGLWidget(inst->getEngine());
+						}
 					}catch(OBException* ex){
 						OBEngine* eng = inst->getEngine();
 						if(eng){
@@ -300,6 +259,12 @@ namespace OB{
 					}
 				}
 			}
+
+			if(undoWidget){
+				undoWidget->recordUndo(cmd);
+			}else{
+				delete cmd;
+			}
 		}
 
 		PropertyItem* PropertyTreeWidget::propertyItemAt(const QModelIndex &index){
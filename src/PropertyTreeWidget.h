@@ -24,6 +24,11 @@
 
 #include <instance/Instance.h>
 
+#include "SelectionSet.h"
+#include "PropertySchema.h"
+
+#include <unordered_map>
+
 namespace OB{
 	namespace Studio{
 		class PropertyItem;
@@ -33,15 +38,16 @@ namespace OB{
 			PropertyTreeWidget();
 			virtual ~PropertyTreeWidget();
 
-			void updateSelection(std::vector<shared_ptr<Instance::Instance>> selectedInstances);
+			void updateSelection(SelectionSnapshot selectedInstances);
 			void updateValue(std::string prop);
-			void setProp(std::string prop, shared_ptr<Type::VarWrapper> val);
+			void updateValue(PropertyId prop);
+			void setProp(PropertyId prop, shared_ptr<Type::VarWrapper> val);
 
 			PropertyItem* propertyItemAt(const QModelIndex &index);
 
 		private:
-			std::vector<shared_ptr<Instance::Instance>> editingInstances;
-			std::map<std::string, PropertyItem*> curProps;
+			SelectionSnapshot editingInstances;
+			std::unordered_map<PropertyId, PropertyItem*> curProps;
 		};
 	}
 }
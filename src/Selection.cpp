@@ -24,7 +24,6 @@
 
 #include <OBException.h>
 
-#include "StudioWindow.h"
 #include "StudioGLWidget.h"
 
 namespace OB{
@@ -57,15 +56,8 @@ namespace OB{
 		}
 
 		std::vector<shared_ptr<Instance>> Selection::Get(){
-			Studio::StudioWindow* win = Studio::StudioWindow::static_win;
-
-			if(win){
-				Studio::StudioGLWidget* gW = win->getCurrentGLWidget(eng);
-				if(gW){
-					return gW->selectedInstances;
-				}
-			}
-			return std::vector<shared_ptr<Instance>>();
+			// May be on a tick thread, so no widgets are touched
+			return Studio::StudioGLWidget::selectionFor(eng).list();
 		}
 
 		int Selection::lua_Get(lua_State* L){
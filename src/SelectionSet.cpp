@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "SelectionSet.h"
+
+#include <algorithm>
+
+namespace OB{
+	namespace Studio{
+		static const InstanceList& ob_studio_empty_list(){
+			static const InstanceList emptyList;
+			return emptyList;
+		}
+
+		// SelectionSnapshot
+
+		SelectionSnapshot::SelectionSnapshot(){
+			items = NULL;
+		}
+
+		SelectionSnapshot::SelectionSnapshot(shared_ptr<const InstanceList> items){
+			this->items = items;
+		}
+
+		size_t SelectionSnapshot::size() const{
+			return list().size();
+		}
+
+		bool SelectionSnapshot::empty() const{
+			return list().empty();
+		}
+
+		const shared_ptr<Instance::Instance>& SelectionSnapshot::at(size_t i) const{
+			return list().at(i);
+		}
+
+		const shared_ptr<Instance::Instance>& SelectionSnapshot::operator[](size_t i) const{
+			return list()[i];
+		}
+
+		InstanceList::const_iterator SelectionSnapshot::begin() const{
+			return list().begin();
+		}
+
+		InstanceList::const_iterator SelectionSnapshot::end() const{
+			return list().end();
+		}
+
+		const InstanceList& SelectionSnapshot::list() const{
+			if(items){
+				return *items;
+			}
+			return ob_studio_empty_list();
+		}
+
+		// SelectionSet
+
+		SelectionSet::SelectionSet(){
+			items = make_shared<InstanceList>();
+		}
+
+		bool SelectionSet::contains(Instance::Instance* inst) const{
+			return members.find(inst) != members.end();
+		}
+
+		bool SelectionSet::contains(const shared_ptr<Instance::Instance>& inst) const{
+			return contains(inst.get());
+		}
+
+		size_t SelectionSet::size() const{
+			return items->size();
+		}
+
+		bool SelectionSet::empty() const{
+			return items->empty();
+		}
+
+		const shared_ptr<Instance::Instance>& SelectionSet::at(size_t i) const{
+			return items->at(i);
+		}
+
+		InstanceList::const_iterator SelectionSet::begin() const{
+			return items->begin();
+		}
+
+		InstanceList::const_iterator SelectionSet::end() const{
+			return items->end();
+		}
+
+		const InstanceList& SelectionSet::list() const{
+			return *items;
+		}
+
+		SelectionSnapshot SelectionSet::snapshot() const{
+			return SelectionSnapshot(items);
+		}
+
+		SelectionSnapshot SelectionSet::sharedSnapshot() const{
+			QMutexLocker locker(&itemsLock);
+			return SelectionSnapshot(items);
+		}
+
+		void SelectionSet::detach(){
+			if(items.use_count() > 1){
+				items = make_shared<InstanceList>(*items);
+			}
+		}
+
+		bool SelectionSet::add(shared_ptr<Instance::Instance> inst){
+			if(!inst || contains(inst)){
+				return false;
+			}
+
+			QMutexLocker locker(&itemsLock);
+			detach();
+			items->push_back(inst);
+			members.insert(inst.get());
+			return true;
+		}
+
+		bool SelectionSet::remove(shared_ptr<Instance::Instance> inst){
+			if(!inst || !contains(inst)){
+				return false;
+			}
+
+			QMutexLocker locker(&itemsLock);
+			detach();
+			items->erase(std::find(items->begin(), items->end(), inst));
+			members.erase(inst.get());
+			return true;
+		}
+
+		void SelectionSet::assign(const InstanceList& insts){
+			QMutexLocker locker(&itemsLock);
+
+			// Snapshots keep the old list, so this one can't be shared
+			// by the time it's reserved or filled
+			if(items.use_count() > 1){
+				items = make_shared<InstanceList>();
+			}else{
+				items->clear();
+			}
+			members.clear();
+
+			items->reserve(insts.size());
+			members.reserve(insts.size());
+			for(size_t i = 0; i < insts.size(); i++){
+				shared_ptr<Instance::Instance> inst = insts[i];
+				if(inst && members.insert(inst.get()).second){
+					items->push_back(inst);
+				}
+			}
+		}
+
+		void SelectionSet::clear(){
+			QMutexLocker locker(&itemsLock);
+
+			// Don't disturb anyone holding a snapshot
+			if(items.use_count() > 1){
+				items = make_shared<InstanceList>();
+			}else{
+				items->clear();
+			}
+			members.clear();
+		}
+	}
+}
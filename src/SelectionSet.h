@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OB_STUDIO_SELECTIONSET_H_
+#define OB_STUDIO_SELECTIONSET_H_
+
+#include <instance/Instance.h>
+
+#include <QMutex>
+
+#include <unordered_set>
+#include <vector>
+
+namespace OB{
+	namespace Studio{
+		typedef std::vector<shared_ptr<Instance::Instance>> InstanceList;
+
+		/*
+		 * Immutable view of a selection at some point in time. Taking
+		 * one is O(1), it shares storage with the SelectionSet until
+		 * the set is next modified.
+		 */
+		class SelectionSnapshot{
+		public:
+			SelectionSnapshot();
+			SelectionSnapshot(shared_ptr<const InstanceList> items);
+
+			size_t size() const;
+			bool empty() const;
+
+			const shared_ptr<Instance::Instance>& at(size_t i) const;
+			const shared_ptr<Instance::Instance>& operator[](size_t i) const;
+
+			InstanceList::const_iterator begin() const;
+			InstanceList::const_iterator end() const;
+
+			const InstanceList& list() const;
+
+		private:
+			shared_ptr<const InstanceList> items;
+		};
+
+		/*
+		 * The set of selected instances in a tab. Membership tests are
+		 * O(1) and iteration follows selection order. Storage is copy
+		 * on write, so snapshots stay valid while the set changes.
+		 *
+		 * Only the GUI thread may change or read the set directly.
+		 * Other threads take a sharedSnapshot(), which is safe
+		 * against changes being made at the same time.
+		 */
+		class SelectionSet{
+		public:
+			SelectionSet();
+
+			bool contains(Instance::Instance* inst) const;
+			bool contains(const shared_ptr<Instance::Instance>& inst) const;
+
+			size_t size() const;
+			bool empty() const;
+
+			const shared_ptr<Instance::Instance>& at(size_t i) const;
+
+			InstanceList::const_iterator begin() const;
+			InstanceList::const_iterator end() const;
+
+			const InstanceList& list() const;
+			SelectionSnapshot snapshot() const;
+			SelectionSnapshot sharedSnapshot() const;
+
+			bool add(shared_ptr<Instance::Instance> inst);
+			bool remove(shared_ptr<Instance::Instance> inst);
+			void assign(const InstanceList& insts);
+			void clear();
+
+		private:
+			void detach();
+
+			shared_ptr<InstanceList> items;
+			std::unordered_set<Instance::Instance*> members;
+
+			// Held while items changes, and while another thread takes
+			// its reference to it
+			mutable QMutex itemsLock;
+		};
+	}
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// End:
@@ -21,6 +21,7 @@
 
 #include "StudioWindow.h"
 #include "InstanceTree.h"
+#include "InstanceClipboard.h"
 
 #include <openblox.h>
 #include <instance/LogService.h>
@@ -28,6 +29,9 @@
 #include <functional>
 
 #include <QtGui>
+#include <QApplication>
+#include <QClipboard>
+#include <QScrollBar>
 
 // Native keycodes
 #ifdef _WIN32
@@ -39,6 +43,10 @@
 
 namespace OB{
 	namespace Studio{
+		// Tabs by engine, for threads that can't walk the tab widget
+		static QMutex ob_studio_tabs_lock;
+		static std::unordered_map<OBEngine*, StudioGLWidget*> ob_studio_tabs;
+
 		StudioGLWidget::StudioGLWidget(OBEngine* eng) : StudioTabWidget(eng){
 			setAttribute(Qt::WA_OpaquePaintEvent);
 			setFocusPolicy(Qt::StrongFocus);
@@ -51,10 +59,591 @@ namespace OB{
 			draw_axis = false;
 
 			has_focus = false;
-			logHist = "";
+			logFile = NULL;
+
+			explorerModel = NULL;
+			explorerSelection = NULL;
+			explorerScroll = 0;
+
+			guiHoldsEngine = false;
+			tickThread = NULL;
+			loader = NULL;
+			saver = NULL;
+
+			journal = NULL;
+			modified = false;
+
+			commandRunner = NULL;
+
+			backgroundTickPolicy = TickPolicy::Default;
+
+			QMutexLocker locker(&ob_studio_tabs_lock);
+			ob_studio_tabs[eng] = this;
 		}
 
-		StudioGLWidget::~StudioGLWidget(){}
+		StudioGLWidget::~StudioGLWidget(){
+			{
+				QMutexLocker locker(&ob_studio_tabs_lock);
+				auto it = ob_studio_tabs.find(eng);
+				if(it != ob_studio_tabs.end() && it->second == this){
+					ob_studio_tabs.erase(it);
+				}
+			}
+
+			stopLoader();
+			stopSaver();
+
+			// Copied instances can't outlive their engine
+			InstanceMimeData* copied = dynamic_cast<InstanceMimeData*>(const_cast<QMimeData*>(QApplication::clipboard()->mimeData()));
+			if(copied && copied->getSource() == this){
+				copied->detachSource();
+			}
+
+			stopTickThread();
+
+			delete commandRunner;
+
+			StudioWindow* win = StudioWindow::static_win;
+			if(win && explorerModel && win->explorer->instanceModel() == explorerModel){
+				win->setExplorerModel(NULL, NULL);
+			}
+			if(win && win->outputFilter->getLog() == &outputLog){
+				win->setOutputLog(NULL);
+			}
+
+			if(logConn){
+				logConn->Disconnect();
+			}
+			if(dmChangedConn){
+				dmChangedConn->Disconnect();
+			}
+
+			// Deleting the model disconnects all of its instance events
+			delete explorerSelection;
+			delete explorerModel;
+
+			delete journal;
+			delete logFile;
+		}
+
+		SelectionSnapshot StudioGLWidget::selectionFor(OBEngine* eng){
+			// Held until the snapshot is taken, so the tab can't go
+			// away underneath us
+			QMutexLocker locker(&ob_studio_tabs_lock);
+
+			auto it = ob_studio_tabs.find(eng);
+			if(it == ob_studio_tabs.end()){
+				return SelectionSnapshot();
+			}
+			return it->second->selectedInstances.sharedSnapshot();
+		}
+
+		static bool ob_studio_on_gui_thread(){
+			return QThread::currentThread() == qApp->thread();
+		}
+
+		TickPolicy StudioGLWidget::getBackgroundTickPolicy(){
+			return backgroundTickPolicy;
+		}
+
+		void StudioGLWidget::setBackgroundTickPolicy(TickPolicy policy){
+			backgroundTickPolicy = policy;
+			applyTickPolicy();
+		}
+
+		TickPolicy StudioGLWidget::getTickPolicy(){
+			// Nothing runs until the whole place is in
+			if(loader){
+				return TickPolicy::Paused;
+			}
+
+			if(has_focus){
+				return TickPolicy::Full;
+			}
+
+			if(backgroundTickPolicy == TickPolicy::Default){
+				FrameScheduler* sched = StudioWindow::static_win->scheduler;
+				if(sched){
+					return sched->getBackgroundPolicy();
+				}
+				return TickPolicy::Full;
+			}
+
+			return backgroundTickPolicy;
+		}
+
+		void StudioGLWidget::applyTickPolicy(){
+			if(!tickThread){
+				return;
+			}
+
+			FrameScheduler* sched = StudioWindow::static_win->scheduler;
+			if(!sched){
+				return;
+			}
+
+			switch(getTickPolicy()){
+				case TickPolicy::Paused: {
+					tickThread->setPaused(true);
+					break;
+				}
+				case TickPolicy::Reduced: {
+					tickThread->setTickRate(sched->getBackgroundTickRate());
+					tickThread->setPaused(false);
+					break;
+				}
+				default: {
+					tickThread->setTickRate(sched->getTickRate());
+					tickThread->setPaused(false);
+					break;
+				}
+			}
+		}
+
+		// Used when ticking from the GUI thread, which runs at the full
+		// tick rate. Reduced tabs skip ticks until enough time passed.
+		bool StudioGLWidget::tickDue(){
+			switch(getTickPolicy()){
+				case TickPolicy::Paused: {
+					return false;
+				}
+				case TickPolicy::Reduced: {
+					FrameScheduler* sched = StudioWindow::static_win->scheduler;
+					if(sched && lastTick.isValid()){
+						if(lastTick.nsecsElapsed() < 1000000000LL / sched->getBackgroundTickRate()){
+							return false;
+						}
+					}
+					break;
+				}
+				default: {
+					break;
+				}
+			}
+
+			lastTick.start();
+			return true;
+		}
+
+		void StudioGLWidget::startTickThread(){
+			if(!eng){
+				return;
+			}
+
+			if(!tickThread){
+				tickThread = new EngineTickThread(eng, &engineLock);
+			}
+			applyTickPolicy();
+
+			if(!tickThread->isRunning()){
+				tickThread->start();
+			}
+		}
+
+		void StudioGLWidget::stopTickThread(){
+			if(tickThread){
+				// The thread may be waiting on a lock we hold
+				bool wasHeld = guiHoldsEngine;
+				unlockEngine();
+
+				tickThread->requestStop();
+				tickThread->wait();
+
+				delete tickThread;
+				tickThread = NULL;
+
+				if(wasHeld){
+					lockEngine();
+				}
+			}
+
+			// Anything the thread queued up still belongs to us
+			drainUiQueue();
+		}
+
+		bool StudioGLWidget::hasTickThread(){
+			return tickThread != NULL;
+		}
+
+		// Only ever called from the GUI thread, which may hold the lock
+		// across any number of events, so we track it ourselves.
+		void StudioGLWidget::lockEngine(){
+			if(!guiHoldsEngine){
+				engineLock.lock();
+				guiHoldsEngine = true;
+			}
+		}
+
+		void StudioGLWidget::unlockEngine(){
+			if(guiHoldsEngine){
+				guiHoldsEngine = false;
+				engineLock.unlock();
+			}
+		}
+
+		bool StudioGLWidget::tryLockEngine(){
+			if(guiHoldsEngine){
+				return true;
+			}
+			if(engineLock.tryLock()){
+				guiHoldsEngine = true;
+				return true;
+			}
+			return false;
+		}
+
+		// While a loader or saver owns the engine the GUI thread only
+		// takes it if it's free.
+		bool StudioGLWidget::acquireEngine(){
+			if(isBusy()){
+				return tryLockEngine();
+			}
+			lockEngine();
+			return true;
+		}
+
+		bool StudioGLWidget::holdsEngine(){
+			return guiHoldsEngine;
+		}
+
+		void StudioGLWidget::loadPlace(QString fileName){
+			if(loader || !eng){
+				return;
+			}
+
+			fileOpened = fileName;
+
+			loader = new PlaceLoader(fileName, eng, &engineLock);
+			applyTickPolicy();
+
+			// Input would reach the engine without the lock, and the
+			// explorer would read instances as they're being built
+			setEnabled(false);
+
+			StudioWindow* win = StudioWindow::static_win;
+			if(explorerModel && win->explorer->instanceModel() == explorerModel){
+				win->setExplorerModel(NULL, NULL);
+			}
+
+			bool wasHeld = guiHoldsEngine;
+			unlockEngine();
+			loader->start();
+			if(wasHeld){
+				tryLockEngine();
+			}
+		}
+
+		PlaceLoader* StudioGLWidget::getLoader(){
+			return loader;
+		}
+
+		// True until everything the loader built has reached the GUI
+		bool StudioGLWidget::isLoading(){
+			return loader != NULL;
+		}
+
+		bool StudioGLWidget::finishLoad(){
+			if(!loader || !loader->isDone() || !uiQueue.isEmpty()){
+				return false;
+			}
+
+			bool newBaseline = false;
+			if(loader->getState() == PlaceTask::State::Done){
+				if(loader->isRecovery()){
+					// Keep writing to the journal we recovered from, the
+					// game hasn't been saved anywhere yet
+					delete journal;
+					journal = new AutosaveJournal(fileOpened);
+					fileOpened = journal->getBaseFile();
+					modified = true;
+				}else{
+					journal->reset();
+					journal->setBaseFile(fileOpened);
+					newBaseline = true;
+					modified = false;
+				}
+			}else{
+				fileOpened = "";
+			}
+
+			loader->wait();
+			delete loader;
+			loader = NULL;
+
+			// Catch up on anything we skipped while the loader had it
+			bool wasHeld = guiHoldsEngine;
+			lockEngine();
+
+			// Journal records build on the game as it was loaded
+			if(newBaseline){
+				journal->setBaseline(eng);
+			}
+
+			eng->resized(width(), height());
+			if(has_focus){
+				OBInputEventReceiver* ier = eng->getInputEventReceiver();
+				if(ier){
+					ier->focus();
+				}
+			}
+
+			// The focused tab's engine stays ours until the event
+			// loop next blocks
+			if(!wasHeld && !has_focus){
+				unlockEngine();
+			}
+
+			setEnabled(true);
+			applyTickPolicy();
+
+			if(has_focus && explorerModel){
+				StudioWindow::static_win->setExplorerModel(explorerModel, explorerSelection);
+			}
+
+			return true;
+		}
+
+		void StudioGLWidget::stopLoader(){
+			if(loader){
+				// The loader may be waiting on a lock we hold
+				bool wasHeld = guiHoldsEngine;
+				unlockEngine();
+
+				loader->cancel();
+				loader->wait();
+
+				if(wasHeld){
+					lockEngine();
+				}
+
+				drainUiQueue();
+				finishLoad();
+			}
+		}
+
+		void StudioGLWidget::savePlace(QString fileName, bool autosave){
+			if(saver || loader || !eng){
+				return;
+			}
+
+			saver = new PlaceSaver(fileName, eng, &engineLock, autosave);
+
+			// Same as loading, but only until it's serialized
+			setEnabled(false);
+
+			bool wasHeld = guiHoldsEngine;
+			unlockEngine();
+			saver->start();
+			if(wasHeld){
+				tryLockEngine();
+			}
+		}
+
+		PlaceSaver* StudioGLWidget::getSaver(){
+			return saver;
+		}
+
+		bool StudioGLWidget::isSaving(){
+			return saver != NULL;
+		}
+
+		bool StudioGLWidget::finishSave(){
+			if(!saver){
+				return false;
+			}
+
+			if(!saver->ownsEngine()){
+				setEnabled(true);
+			}
+
+			if(!saver->isDone()){
+				return false;
+			}
+
+			saver->wait();
+
+			if(saver->isAutosave()){
+				journal->endSnapshot(saver->getState() == PlaceTask::State::Done, saver->getSaved());
+			}else if(saver->getState() == PlaceTask::State::Done){
+				// The journal only has to get us back to this file now
+				journal->reset();
+				journal->setBaseFile(saver->getFileName());
+				journal->setBaseline(saver->getSaved());
+				modified = false;
+			}
+
+			delete saver;
+			saver = NULL;
+
+			// The focused tab's engine is normally always ours
+			if(has_focus){
+				lockEngine();
+			}
+
+			return true;
+		}
+
+		// Unlike loading, a save in progress is always finished
+		void StudioGLWidget::stopSaver(){
+			if(saver){
+				bool wasHeld = guiHoldsEngine;
+				unlockEngine();
+
+				saver->wait();
+
+				if(wasHeld){
+					lockEngine();
+				}
+
+				finishSave();
+			}
+		}
+
+		bool StudioGLWidget::isBusy(){
+			return loader || (saver && saver->ownsEngine());
+		}
+
+		bool StudioGLWidget::startCommand(QString code, CommandCache* cache, bool* cacheHit){
+			if(!commandRunner || isBusy()){
+				return false;
+			}
+			return commandRunner->start(code, cache, cacheHit);
+		}
+
+		bool StudioGLWidget::isRunningCommand(){
+			return commandRunner && commandRunner->isRunning();
+		}
+
+		// Caller must hold the engine
+		bool StudioGLWidget::stepCommand(int sliceMs){
+			if(!isRunningCommand()){
+				return false;
+			}
+			return commandRunner->step(sliceMs);
+		}
+
+		void StudioGLWidget::stopCommand(){
+			if(commandRunner){
+				commandRunner->stop();
+			}
+		}
+
+		void StudioGLWidget::beginBulkUpdate(){
+			if(explorerModel){
+				explorerModel->beginBatch();
+			}
+		}
+
+		void StudioGLWidget::endBulkUpdate(){
+			if(explorerModel){
+				explorerModel->endBatch();
+			}
+
+			StudioWindow* win = StudioWindow::static_win;
+			if(win && has_focus){
+				win->update_toolbar_usability();
+			}
+		}
+
+		// Instances that refuse the new parent stay where they are
+		// and are left out of cmd
+		void StudioGLWidget::reparent(const std::vector<shared_ptr<Instance::Instance>>& insts, shared_ptr<Instance::Instance> newParent, UndoCommand* cmd){
+			BulkUpdate bulk(this);
+
+			for(size_t i = 0; i < insts.size(); i++){
+				shared_ptr<Instance::Instance> inst = insts[i];
+				if(!inst){
+					continue;
+				}
+
+				shared_ptr<Instance::Instance> oldParent = inst->getParent();
+				try{
+					inst->setParent(newParent, true);
+				}catch(OBException* ex){
+					continue;
+				}
+
+				if(cmd){
+					cmd->addReparent(inst, oldParent, newParent);
+				}
+			}
+		}
+
+		// BulkUpdate
+
+		BulkUpdate::BulkUpdate(StudioGLWidget* gW){
+			this->gW = gW;
+			gW->beginBulkUpdate();
+		}
+
+		BulkUpdate::~BulkUpdate(){
+			gW->endBulkUpdate();
+		}
+
+		UndoStack* StudioGLWidget::getUndoStack(){
+			return &undoStack;
+		}
+
+		// For changes that have already been made
+		void StudioGLWidget::recordUndo(UndoCommand* cmd){
+			undoStack.push(cmd);
+
+			StudioWindow* win = StudioWindow::static_win;
+			if(win){
+				win->updateUndoActions();
+			}
+		}
+
+		AutosaveJournal* StudioGLWidget::getJournal(){
+			return journal;
+		}
+
+		bool StudioGLWidget::isModified(){
+			return modified;
+		}
+
+		// Writes what changed since the last autosave. Returns true if
+		// a snapshot was started, it finishes like any other save.
+		bool StudioGLWidget::autosave(){
+			if(!journal || !eng || loader || saver){
+				return false;
+			}
+
+			if(journal->isSnapshotDue()){
+				savePlace(journal->beginSnapshot(), true);
+				return true;
+			}
+
+			if(!journal->hasPendingChanges()){
+				return false;
+			}
+
+			// Background tabs may be ticking on their own thread
+			bool wasHeld = guiHoldsEngine;
+			if(!wasHeld && !tryLockEngine()){
+				return false;
+			}
+
+			journal->writeDelta(eng);
+
+			if(!wasHeld){
+				unlockEngine();
+			}
+
+			return false;
+		}
+
+		void StudioGLWidget::runOnGui(std::function<void()> task){
+			if(ob_studio_on_gui_thread()){
+				task();
+			}else{
+				uiQueue.push(task);
+			}
+		}
+
+		int StudioGLWidget::drainUiQueue(int maxTasks){
+			return uiQueue.drain(maxTasks);
+		}
 
 		QSize StudioGLWidget::minimumSizeHint() const{
 			return QSize(320, 240);
@@ -83,9 +672,20 @@ namespace OB{
 				shared_ptr<OB::Instance::LogService> ls = dm->getLogService();
 				if(ls){
 					std::function<void(std::vector<shared_ptr<Type::VarWrapper>>)> lsb = std::bind(&StudioGLWidget::handle_log_event, this, _1);
-					ls->getMessageOut()->Connect(lsb);
+					logConn = ls->getMessageOut()->Connect(lsb);
 				}
+
+				dmChangedConn = dm->Changed->Connect(std::bind(&StudioGLWidget::dm_changed_evt, this, _1));
+
+				// The explorer state lives as long as the tab does,
+				// switching tabs only swaps it in and out of the dock
+				explorerModel = new InstanceTreeModel(this, dynamic_pointer_cast<Instance::Instance>(dm));
+				explorerSelection = new QItemSelectionModel(explorerModel, this);
+				connect(explorerSelection, &QItemSelectionModel::selectionChanged, win, &StudioWindow::selectionChanged);
 			}
+
+			journal = new AutosaveJournal();
+			commandRunner = new CommandRunner(eng);
 		}
 
 		void StudioGLWidget::do_render(){
@@ -140,8 +740,27 @@ namespace OB{
 
 		void StudioGLWidget::remove_focus(){
 			has_focus = false;
+			applyTickPolicy();
+
+			StudioWindow* win = StudioWindow::static_win;
+			if(explorerModel && win->explorer->instanceModel() == explorerModel){
+				// The view forgets expansion when its model changes, so
+				// remember what was open. Only populated nodes can be.
+				explorerExpanded.clear();
+				QModelIndexList populated = explorerModel->populatedIndexes();
+				for(int i = 0; i < populated.size(); i++){
+					if(win->explorer->isExpanded(populated[i])){
+						explorerExpanded.append(QPersistentModelIndex(populated[i]));
+					}
+				}
+				explorerScroll = win->explorer->verticalScrollBar()->value();
+
+				win->setExplorerModel(NULL, NULL);
+			}
 
-			StudioWindow::static_win->explorer->invisibleRootItem()->takeChildren();
+			if(win->outputFilter && win->outputFilter->getLog() == &outputLog){
+				win->setOutputLog(NULL);
+			}
 
 			if(eng){
 				OBInputEventReceiver* ier = eng->getInputEventReceiver();
@@ -155,18 +774,30 @@ namespace OB{
 			using namespace std::placeholders;
 
 			has_focus = true;
+			applyTickPolicy();
 
-			shared_ptr<OB::Instance::DataModel> dm = eng->getDataModel();
-			if(dm){
-				addDM(StudioWindow::static_win->explorer->invisibleRootItem(), dynamic_pointer_cast<Instance::Instance>(dm));
+			StudioWindow* win = StudioWindow::static_win;
+
+			if(explorerModel && !isLoading()){
+				win->setExplorerModel(explorerModel, explorerSelection);
+
+				for(int i = 0; i < explorerExpanded.size(); i++){
+					if(explorerExpanded[i].isValid()){
+						win->explorer->setExpanded(explorerExpanded[i], true);
+					}
+				}
+				explorerExpanded.clear();
+
+				win->explorer->verticalScrollBar()->setValue(explorerScroll);
 			}
 
-			StudioWindow* win = StudioWindow::static_win;
-			if(win->output){
-				win->output->setHtml(logHist);
+			if(win->outputFilter){
+				outputLog.flush();
+				win->setOutputLog(&outputLog);
 			}
 
-			if(eng){
+			// A loader may have the engine, finishLoad() catches up
+			if(eng && guiHoldsEngine){
 				OBInputEventReceiver* ier = eng->getInputEventReceiver();
 				if(ier){
 					ier->focus();
@@ -177,7 +808,7 @@ namespace OB{
 		void StudioGLWidget::resizeEvent(QResizeEvent* evt){
 			QWidget::resizeEvent(evt);
 
-			if(eng){
+			if(eng && (guiHoldsEngine || !isBusy())){
 				QSize newSize = evt->size();
 				eng->resized(newSize.width(), newSize.height());
 			}
@@ -803,32 +1434,56 @@ namespace OB{
 
 		// Explorer/log handling
 		void StudioGLWidget::sendOutput(QString msg){
-			QString emsg = msg.toHtmlEscaped().replace('\n', "<br/>") + "<br/>";
-			logHist = logHist + emsg;
+			outputLog.append(msg);
+		}
 
-			if(has_focus){
-				StudioWindow* win = StudioWindow::static_win;
+		void StudioGLWidget::sendOutput(QString msg, QColor col){
+			outputLog.append(msg, OutputLevel::Info, col);
+		}
 
-				if(win->output){
-					win->output->append(emsg);
-				}
-			}
+		OutputLog* StudioGLWidget::getOutputLog(){
+			return &outputLog;
 		}
 
-		void StudioGLWidget::sendOutput(QString msg, QColor col){
-			QString emsg = "<font color=\"" + col.name() + "\">" + msg.toHtmlEscaped().replace('\n', "<br/>") + "</font><br/>";
-			logHist = logHist + emsg;
+		// True if there were new lines
+		bool StudioGLWidget::flushOutput(){
+			StudioWindow* win = StudioWindow::static_win;
+			bool shown = has_focus && win->outputFilter && win->outputFilter->getLog() == &outputLog;
 
-			if(has_focus){
-				StudioWindow* win = StudioWindow::static_win;
+			// Only follow new lines if the user hasn't scrolled up
+			QScrollBar* bar = shown ? win->output->verticalScrollBar() : NULL;
+			bool atBottom = bar && bar->value() == bar->maximum();
 
-				if(win->output){
-					win->output->append(emsg);
-				}
+			bool added = outputLog.flush();
+			if(added && atBottom){
+				win->output->scrollToBottom();
 			}
+
+			if(logFile){
+				logFile->flush();
+			}
+
+			return added;
+		}
+
+		void StudioGLWidget::setLogFile(LogFileSink* sink){
+			if(logFile == sink){
+				return;
+			}
+			delete logFile;
+			logFile = sink;
+		}
+
+		LogFileSink* StudioGLWidget::getLogFile(){
+			return logFile;
 		}
 
 		void StudioGLWidget::handle_log_event(std::vector<shared_ptr<OB::Type::VarWrapper>> evec){
+			if(!ob_studio_on_gui_thread()){
+				uiQueue.push(std::bind(&StudioGLWidget::handle_log_event, this, evec));
+				return;
+			}
+
 			// Temporary
 			QColor errorCol(255, 51, 0);
 			QColor warnCol(242, 97, 0);
@@ -838,134 +1493,132 @@ namespace OB{
 				QString msg = evec.at(0)->asString().c_str();
 				shared_ptr<Type::LuaEnumItem> msgType = dynamic_pointer_cast<Type::LuaEnumItem>(evec.at(1)->asType());
 
+				OutputLevel level = OutputLevel::Info;
 				if(msgType->getValue() == (int)Enum::MessageType::MessageError){
-					sendOutput(msg, errorCol);
+					level = OutputLevel::Error;
+					outputLog.append(msg, level, errorCol);
 				}else if(msgType->getValue() == (int)Enum::MessageType::MessageWarning){
-					sendOutput(msg, warnCol);
+					level = OutputLevel::Warning;
+					outputLog.append(msg, level, warnCol);
 				}else{
-					sendOutput(msg);
+					outputLog.append(msg);
+				}
+
+				// The file gets everything, repeats and all
+				if(logFile){
+					logFile->write(QDateTime::currentMSecsSinceEpoch(), level, msg);
 				}
 			}
 		}
 
-		void StudioGLWidget::instance_changed_evt(std::vector<shared_ptr<Type::VarWrapper>> evec, InstanceTreeItem* kidItem){
-			if(!kidItem){
+		void StudioGLWidget::instance_changed_evt(std::weak_ptr<Instance::Instance> kid, std::string prop){
+			if(!ob_studio_on_gui_thread()){
+				uiQueue.push(std::bind(&StudioGLWidget::instance_changed_evt, this, kid, prop));
 				return;
 			}
 
-			shared_ptr<Instance::Instance> kid = kidItem->GetInstance();
-			if(!kid){
+			shared_ptr<Instance::Instance> sKid = kid.lock();
+			if(!sKid){
 				return;
 			}
 
-			std::string prop = evec.at(0)->asString();
+			if(journal){
+				journal->markPropertyChanged(sKid, prop);
+				modified = true;
+			}
 
-			if(StudioWindow::static_win){
-				std::vector<shared_ptr<Instance::Instance>> selection = selectedInstances;
+			auto it = pendingChangeIdx.find(sKid.get());
+			if(it == pendingChangeIdx.end()){
+				pendingChangeIdx[sKid.get()] = pendingChanges.size();
 
-				if(!selection.empty()){
-					if(std::find(selection.begin(), selection.end(), kid) != selection.end()){
-						StudioWindow::static_win->properties->updateValue(prop);
-					}
-				}
+				PendingChange change;
+				change.inst = kid;
+				change.props.push_back(prop);
+				pendingChanges.push_back(change);
+				return;
 			}
 
-			if(prop == "Name"){
-				const QSignalBlocker sigBlock(kidItem->treeWidget());
-				kidItem->setText(0, QString(kid->getName().c_str()));
-				return;
+			PendingChange& change = pendingChanges[it->second];
+			if(change.inst.expired()){
+				// Same address, different instance
+				change.inst = kid;
+				change.props.clear();
 			}
-			if(prop == "Parent" || prop == "ParentLocked"){
-				kidItem->updateFlags();
-				return;
+
+			// Instances rarely change more than a handful of properties
+			// per frame, a linear scan beats hashing here
+			std::vector<std::string>& props = change.props;
+			if(std::find(props.begin(), props.end(), prop) == props.end()){
+				props.push_back(prop);
 			}
 		}
 
-		void StudioGLWidget::instance_child_added_evt(std::vector<shared_ptr<Type::VarWrapper>> evec, QTreeWidgetItem* kidItem){
-			if(!kidItem){
-				return;
+		// True if anything changed since the last flush
+		bool StudioGLWidget::flushChanges(){
+			if(pendingChanges.empty()){
+				return false;
 			}
 
-			if(evec.size() == 1){
-				if(kidItem->isSelected()){
-					StudioWindow* win = StudioWindow::static_win;
-					if(win){
-						win->update_toolbar_usability();
-					}
-				}
-				shared_ptr<Instance::Instance> newGuy = evec[0]->asInstance();
-				if(treeItemMap.contains(newGuy)){
-					InstanceTreeItem* ngti = treeItemMap.value(newGuy);
-					QTreeWidgetItem* twi = ngti->parent();
-					if(twi != kidItem){
-						if(twi){
-							twi->removeChild(ngti);
-						}
-						kidItem->addChild(ngti);
-					}
-				}else{
-					addChildOfInstance(kidItem, newGuy);
+			std::vector<PendingChange> changes;
+			changes.swap(pendingChanges);
+			pendingChangeIdx.clear();
+
+			std::set<std::string> panelProps;
+
+			for(size_t i = 0; i < changes.size(); i++){
+				shared_ptr<Instance::Instance> inst = changes[i].inst.lock();
+				if(!inst){
+					continue;
 				}
-			}
-		}
 
-		void StudioGLWidget::instance_child_removed_evt(std::vector<shared_ptr<Type::VarWrapper>> evec, QTreeWidgetItem* kidItem){
-			if(!kidItem){
-				return;
-			}
+				const std::vector<std::string>& props = changes[i].props;
 
-			if(evec.size() == 1){
-				if(kidItem->isSelected()){
-					StudioWindow* win = StudioWindow::static_win;
-					if(win){
-						win->update_toolbar_usability();
+				bool updateRow = false;
+				for(size_t p = 0; p < props.size(); p++){
+					if(InstanceTreeModel::isDisplayedProperty(props[p])){
+						updateRow = true;
+						break;
 					}
 				}
-				shared_ptr<Instance::Instance> newGuy = evec[0]->asInstance();
-				InstanceTreeItem* kTi = treeItemMap.value(newGuy);
-				if(kTi){
-					if(kTi->parent() == kidItem){
-						kidItem->removeChild(kTi);
-					}
+				if(updateRow && explorerModel){
+					explorerModel->instanceChanged(inst);
 				}
-			}
-		}
 
-		void StudioGLWidget::addChildOfInstance(QTreeWidgetItem* parentItem, shared_ptr<Instance::Instance> kid){
-			using namespace std::placeholders;
-
-			if(!parentItem || !kid){
-				return;
+				if(has_focus && selectedInstances.contains(inst)){
+					panelProps.insert(props.begin(), props.end());
+				}
 			}
 
-			InstanceTreeItem* kidItem = new InstanceTreeItem(kid);
-			treeItemMap[kid] = kidItem;
-			kidItem->setIcon(0, StudioWindow::getClassIcon(QString(kid->getClassName().c_str())));
-
-			kid->Changed->Connect(std::bind(&StudioGLWidget::instance_changed_evt, this, _1, kidItem));
-			kid->ChildAdded->Connect(std::bind(&StudioGLWidget::instance_child_added_evt, this, _1, kidItem));
-			kid->ChildRemoved->Connect(std::bind(&StudioGLWidget::instance_child_removed_evt, this, _1, kidItem));
-
-			addChildrenOfInstance(kidItem, kid);
+			StudioWindow* win = StudioWindow::static_win;
+			if(win && !panelProps.empty()){
+				for(auto it = panelProps.begin(); it != panelProps.end(); ++it){
+					win->properties->updateValue(*it);
+				}
+			}
 
-			parentItem->addChild(kidItem);
+			return true;
 		}
 
-		void StudioGLWidget::addChildrenOfInstance(QTreeWidgetItem* parentItem, shared_ptr<Instance::Instance> inst){
-			if(!parentItem || !inst){
-				return;
+		void StudioGLWidget::instance_children_changed(shared_ptr<Instance::Instance> inst){
+			if(journal){
+				journal->markChildrenChanged(inst);
+				modified = true;
 			}
 
-			std::vector<shared_ptr<Instance::Instance>> kids = inst->GetChildren();
-			for(std::vector<shared_ptr<Instance::Instance>>::size_type i = 0; i < kids.size(); i++){
-				shared_ptr<Instance::Instance> kid = kids[i];
-				if(kid){
-					addChildOfInstance(parentItem, kid);
+			if(selectedInstances.contains(inst)){
+				StudioWindow* win = StudioWindow::static_win;
+				if(win){
+					win->update_toolbar_usability();
 				}
 			}
 		}
 
 		void StudioGLWidget::dm_changed_evt(std::vector<shared_ptr<Type::VarWrapper>> evec){
+			if(!ob_studio_on_gui_thread()){
+				uiQueue.push(std::bind(&StudioGLWidget::dm_changed_evt, this, evec));
+				return;
+			}
+
 			StudioWindow* sw = StudioWindow::static_win;
 			if(!sw){
 				return;
@@ -979,25 +1632,5 @@ namespace OB{
 				}
 			}
 		}
-
-		void StudioGLWidget::addDM(QTreeWidgetItem* parentItem, shared_ptr<Instance::Instance> inst){
-			using namespace std::placeholders;
-
-			if(!parentItem || !inst){
-				return;
-			}
-
-			std::vector<shared_ptr<Instance::Instance>> kids = inst->GetChildren();
-			for(std::vector<shared_ptr<Instance::Instance>>::size_type i = 0; i < kids.size(); i++){
-				shared_ptr<Instance::Instance> kid = kids[i];
-				if(kid){
-					addChildOfInstance(parentItem, kid);
-				}
-			}
-
-			inst->ChildAdded->Connect(std::bind(&StudioGLWidget::instance_child_added_evt, this, _1, parentItem));
-			inst->ChildRemoved->Connect(std::bind(&StudioGLWidget::instance_child_removed_evt, this, _1, parentItem));
-			inst->Changed->Connect(std::bind(&StudioGLWidget::dm_changed_evt, this, _1));
-		}
 	}
 }
@@ -22,7 +22,25 @@
 
 #include "StudioTabWidget.h"
 
-#include "InstanceTreeItem.h"
+#include "InstanceTreeModel.h"
+#include "SelectionSet.h"
+#include "UiTaskQueue.h"
+#include "EngineTickThread.h"
+#include "PlaceLoader.h"
+#include "PlaceSaver.h"
+#include "AutosaveJournal.h"
+#include "UndoStack.h"
+#include "CommandRunner.h"
+#include "OutputLog.h"
+#include "LogFileSink.h"
+#include "FrameScheduler.h"
+
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QItemSelectionModel>
+
+#include <unordered_map>
+#include <set>
 
 namespace OB{
 	namespace Studio{
@@ -48,35 +66,91 @@ namespace OB{
 
 			virtual void resizeEvent(QResizeEvent* evt);
 
-			void setLogHistory(QString hist);
-			QString getLogHistory();
-
-			void populateTree(InstanceTree* explorer);
-
-			void saveAct();
-			void saveAsAct();
+			// Tick policy
+			TickPolicy getBackgroundTickPolicy();
+			void setBackgroundTickPolicy(TickPolicy policy);
+			TickPolicy getTickPolicy();
+			void applyTickPolicy();
+			bool tickDue();
+
+			// Engine threading
+			void startTickThread();
+			void stopTickThread();
+			bool hasTickThread();
+
+			void lockEngine();
+			void unlockEngine();
+			bool tryLockEngine();
+			bool acquireEngine();
+			bool holdsEngine();
+
+			void runOnGui(std::function<void()> task);
+			int drainUiQueue(int maxTasks = -1);
+
+			// Place loading
+			void loadPlace(QString fileName);
+			PlaceLoader* getLoader();
+			bool isLoading();
+			bool finishLoad();
+			void stopLoader();
+
+			void savePlace(QString fileName, bool autosave = false);
+			PlaceSaver* getSaver();
+			bool isSaving();
+			bool finishSave();
+			void stopSaver();
+
+			bool isBusy();
+
+			// Command bar
+			// Compiles only, stepCommand() runs it
+			bool startCommand(QString code, CommandCache* cache = NULL, bool* cacheHit = NULL);
+			bool isRunningCommand();
+			bool stepCommand(int sliceMs);
+			void stopCommand();
+
+			// Bulk edits, the explorer catches up once at the end
+			void beginBulkUpdate();
+			void endBulkUpdate();
+			void reparent(const std::vector<shared_ptr<Instance::Instance>>& insts, shared_ptr<Instance::Instance> newParent, UndoCommand* cmd = NULL);
+
+			// Undo
+			UndoStack* getUndoStack();
+			void recordUndo(UndoCommand* cmd);
+
+			// Autosave
+			AutosaveJournal* getJournal();
+			bool isModified();
+			bool autosave();
 
 			QString fileOpened;
 
-			std::vector<shared_ptr<Instance::Instance>> selectedInstances;
+			SelectionSet selectedInstances;
+
+			// Safe from any thread, doesn't touch any widgets
+			static SelectionSnapshot selectionFor(OBEngine* eng);
 
-			// Explorer handling
+			// Output
 			void sendOutput(QString msg, QColor col);
 			void sendOutput(QString msg);
+			OutputLog* getOutputLog();
+			bool flushOutput();
+
+			// Takes ownership, NULL stops logging to a file
+			void setLogFile(LogFileSink* sink);
+			LogFileSink* getLogFile();
 
 			void handle_log_event(std::vector<shared_ptr<OB::Type::VarWrapper>> evec);
 
-			QMap<shared_ptr<Instance::Instance>, InstanceTreeItem*> treeItemMap;
+			InstanceTreeModel* explorerModel;
+			QItemSelectionModel* explorerSelection;
 
 			void post_render_func(irr::video::IVideoDriver* videoDriver);
 
-			void instance_changed_evt(std::vector<shared_ptr<Type::VarWrapper>> evec, InstanceTreeItem* kidItem);
-			void instance_child_added_evt(std::vector<shared_ptr<Type::VarWrapper>> evec, QTreeWidgetItem* kidItem);
-			void instance_child_removed_evt(std::vector<shared_ptr<Type::VarWrapper>> evec, QTreeWidgetItem* kidItem);
-			void addChildOfInstance(QTreeWidgetItem* parentItem, shared_ptr<Instance::Instance> kid);
-			void addChildrenOfInstance(QTreeWidgetItem* parentItem, shared_ptr<Instance::Instance> inst);
+			void instance_changed_evt(std::weak_ptr<Instance::Instance> kid, std::string prop);
+			bool flushChanges();
+			void instance_children_changed(shared_ptr<Instance::Instance> inst);
 			void dm_changed_evt(std::vector<shared_ptr<Type::VarWrapper>> evec);
-			void addDM(QTreeWidgetItem* parentItem, shared_ptr<Instance::Instance> inst);
 
 		protected:
 			void paintGL();
@@ -92,7 +166,55 @@ namespace OB{
 			bool draw_axis;
 
 		private:
-			QString logHist;
+			OutputLog outputLog;
+			LogFileSink* logFile;
+
+			QMutex engineLock;
+			bool guiHoldsEngine;
+
+			EngineTickThread* tickThread;
+			UiTaskQueue uiQueue;
+
+			PlaceLoader* loader;
+			PlaceSaver* saver;
+
+			AutosaveJournal* journal;
+			bool modified;
+
+			UndoStack undoStack;
+
+			CommandRunner* commandRunner;
+
+			TickPolicy backgroundTickPolicy;
+			QElapsedTimer lastTick;
+
+			QList<QPersistentModelIndex> explorerExpanded;
+			int explorerScroll;
+
+			// Property changes since the last flush, one entry per
+			// instance in the order they first changed
+			struct PendingChange{
+				std::weak_ptr<Instance::Instance> inst;
+				std::vector<std::string> props;
+			};
+			std::vector<PendingChange> pendingChanges;
+			std::unordered_map<Instance::Instance*, size_t> pendingChangeIdx;
+
+			shared_ptr<Type::EventConnection> logConn;
+			shared_ptr<Type::EventConnection> dmChangedConn;
+		};
+
+		/*
+		 * Keeps a bulk update open until it goes out of scope, so an
+		 * exception can't leave the explorer batching forever.
+		 */
+		class BulkUpdate{
+		public:
+			BulkUpdate(StudioGLWidget* gW);
+			~BulkUpdate();
+
+		private:
+			StudioGLWidget* gW;
 		};
 	}
 }
@@ -22,12 +22,17 @@
 #include <QtWidgets>
 
 // Studio Widgets
-#include "InstanceTreeItem.h"
+#include "InstanceTreeModel.h"
 #include "ConfigDialog.h"
 #include "InsertAction.h"
 
 // Studio services
 #include "Selection.h"
+#include "BinaryPlace.h"
+#include "AutosaveJournal.h"
+#include "InstanceClipboard.h"
+#include "CommandRunner.h"
+#include "ClassIconTable.h"
 
 // OpenBlox Engine
 #include <openblox.h>
@@ -52,30 +57,8 @@ namespace OB{
 		QSettings* StudioWindow::appSettings = NULL;
 		StudioWindow* StudioWindow::static_win = NULL;
 
-		QMap<QString, QIcon> classIconMap;
-
 		QIcon StudioWindow::getClassIcon(QString className){
-			if(classIconMap.contains(className)){
-				return classIconMap[className];
-			}
-
-			QIcon ico;
-
-			if(className.isEmpty()){
-				return ico;
-			}
-
-			QString icop = ":class_icons/" + className + ".png";
-
-			if(QFile(icop).exists()){
-				ico = QIcon(icop);
-			}else{
-				std::string parentClassStr = ClassFactory::getParentClassName(className.toStdString());
-				ico = getClassIcon(QString(parentClassStr.c_str()));
-			}
-
-			classIconMap[className] = ico;
-			return ico;
+			return ClassIconTable::iconFor(className);
 		}
 
 		StudioWindow::StudioWindow(){
@@ -88,6 +71,9 @@ namespace OB{
 			tabWidget->setMovable(true);
 			connect(tabWidget, &QTabWidget::currentChanged, this, &StudioWindow::tabChanged);
 
+			tabWidget->tabBar()->setContextMenuPolicy(Qt::CustomContextMenu);
+			connect(tabWidget->tabBar(), &QWidget::customContextMenuRequested, this, &StudioWindow::tabContextMenu);
+
 			curTab = NULL;
 
 			setCentralWidget(tabWidget);
@@ -128,15 +114,17 @@ namespace OB{
 
 			QMenu* editMenu = menuBar()->addMenu("Edit");
 			explorerCtxMenu = new QMenu();
-			QAction* undoAction = editMenu->addAction("Undo");
+			undoAction = editMenu->addAction("Undo");
 			undoAction->setIcon(QIcon::fromTheme("edit-undo"));
 			undoAction->setEnabled(false);
 			undoAction->setShortcut(QKeySequence::Undo);
+			connect(undoAction, &QAction::triggered, this, &StudioWindow::undoAct);
 
-			QAction* redoAction = editMenu->addAction("Redo");
+			redoAction = editMenu->addAction("Redo");
 			redoAction->setIcon(QIcon::fromTheme("edit-redo"));
 			redoAction->setEnabled(false);
 			redoAction->setShortcut(QKeySequence::Redo);
+			connect(redoAction, &QAction::triggered, this, &StudioWindow::redoAct);
 
 			editMenu->addSeparator();
 
@@ -211,10 +199,48 @@ namespace OB{
 
 			dock->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea | Qt::BottomDockWidgetArea);
 
-			output = new QTextEdit();
-			output->setReadOnly(true);
+			QWidget* outputPane = new QWidget();
+			QVBoxLayout* outputLayout = new QVBoxLayout(outputPane);
+			outputLayout->setContentsMargins(0, 0, 0, 0);
+			outputLayout->setSpacing(2);
+
+			QHBoxLayout* filterLayout = new QHBoxLayout();
+			filterLayout->setContentsMargins(2, 2, 2, 0);
+
+			outputFilterEdit = new QLineEdit();
+			outputFilterEdit->setPlaceholderText(tr("Filter output"));
+			outputFilterEdit->setClearButtonEnabled(true);
+			filterLayout->addWidget(outputFilterEdit, 1);
+			connect(outputFilterEdit, &QLineEdit::textChanged, this, &StudioWindow::applyOutputFilter);
+
+			outputRegexBox = new QCheckBox(tr("Regex"));
+			filterLayout->addWidget(outputRegexBox);
+			connect(outputRegexBox, &QCheckBox::toggled, this, &StudioWindow::applyOutputFilter);
+
+			const char* levelNames[OB_STUDIO_OUTPUT_LEVELS] = {QT_TR_NOOP("Info"), QT_TR_NOOP("Warnings"), QT_TR_NOOP("Errors")};
+			for(int i = 0; i < OB_STUDIO_OUTPUT_LEVELS; i++){
+				outputLevelBoxes[i] = new QCheckBox(tr(levelNames[i]));
+				outputLevelBoxes[i]->setChecked(true);
+				filterLayout->addWidget(outputLevelBoxes[i]);
+				connect(outputLevelBoxes[i], &QCheckBox::toggled, this, &StudioWindow::applyOutputFilter);
+			}
 
-			dock->setWidget(output);
+			outputMatchLabel = new QLabel();
+			filterLayout->addWidget(outputMatchLabel);
+
+			outputLayout->addLayout(filterLayout);
+
+			// Only visible rows are laid out, all of them the same height
+			outputFilter = new OutputFilter();
+			output = new QListView();
+			output->setUniformItemSizes(true);
+			output->setSelectionMode(QAbstractItemView::ExtendedSelection);
+			output->setEditTriggers(QAbstractItemView::NoEditTriggers);
+			output->setItemDelegate(new OutputDelegate(outputFilter, output));
+			output->setModel(outputFilter);
+			outputLayout->addWidget(output, 1);
+
+			dock->setWidget(outputPane);
 			addDockWidget(Qt::BottomDockWidgetArea, dock);
 			resizeDocks({dock}, {40}, Qt::Horizontal);
 
@@ -231,7 +257,8 @@ namespace OB{
 			explorer->setMinimumSize(100, 100);
 			explorer->setContextMenuPolicy(Qt::CustomContextMenu);
 			connect(explorer, &QWidget::customContextMenuRequested, this, &StudioWindow::explorerContextMenu);
-			connect(explorer, &QTreeWidget::itemSelectionChanged, this, &StudioWindow::selectionChanged);
+
+			updatingSelection = false;
 
 			dock->setWidget(explorer);
 
@@ -281,6 +308,65 @@ namespace OB{
 
 			statusBar();
 
+			scheduler = NULL;
+
+			frameStatsLabel = new QLabel();
+			frameStatsLabel->setVisible(false);
+			statusBar()->addPermanentWidget(frameStatsLabel);
+
+			frameStatsTimer = new QTimer(this);
+			connect(frameStatsTimer, &QTimer::timeout, this, &StudioWindow::updateFrameStats);
+
+			placeProgress = new QProgressBar();
+			placeProgress->setMaximumWidth(200);
+			placeProgress->setVisible(false);
+			statusBar()->addPermanentWidget(placeProgress);
+
+			placeCancelButton = new QPushButton("Cancel");
+			placeCancelButton->setVisible(false);
+			statusBar()->addPermanentWidget(placeCancelButton);
+			connect(placeCancelButton, &QPushButton::clicked, [this](){
+				StudioGLWidget* gW = dynamic_cast<StudioGLWidget*>(curTab);
+				if(gW){
+					if(gW->getLoader()){
+						gW->getLoader()->cancel();
+					}
+					if(gW->getSaver()){
+						gW->getSaver()->cancel();
+					}
+				}
+			});
+
+			placeTimer = new QTimer(this);
+			placeTimer->setInterval(100);
+			connect(placeTimer, &QTimer::timeout, this, &StudioWindow::updatePlaceProgress);
+
+			undoMemoryLimit = OB_STUDIO_DEFAULT_UNDO_MEMORY_LIMIT;
+			outputLimit = OB_STUDIO_DEFAULT_OUTPUT_LINES;
+			outputRateLimit = OB_STUDIO_DEFAULT_OUTPUT_RATE;
+
+			logToFile = false;
+			logFileSize = OB_STUDIO_DEFAULT_LOG_FILE_SIZE;
+			logFileCount = OB_STUDIO_DEFAULT_LOG_FILES;
+			logFileCompress = false;
+
+			autosaveTimer = new QTimer(this);
+			connect(autosaveTimer, &QTimer::timeout, this, &StudioWindow::autosaveAll);
+			setAutosaveInterval(OB_STUDIO_DEFAULT_AUTOSAVE_INTERVAL);
+
+			QAction* frameStatsAct = viewMenu->addAction("Frame Statistics");
+			frameStatsAct->setCheckable(true);
+			frameStatsAct->setChecked(false);
+			connect(frameStatsAct, &QAction::toggled, [this](bool checked){
+				frameStatsLabel->setVisible(checked);
+				if(checked){
+					updateFrameStats();
+					frameStatsTimer->start(1000);
+				}else{
+					frameStatsTimer->stop();
+				}
+			});
+
 			QToolBar* commandBar = new QToolBar("Command");
 			commandBar->setObjectName("studio_command_bar");
 			commandBar->setAllowedAreas(Qt::TopToolBarArea | Qt::BottomToolBarArea);
@@ -307,6 +393,15 @@ namespace OB{
 
 			commandBar->addWidget(cmdBar);
 
+			commandTimeSlice = OB_STUDIO_DEFAULT_COMMAND_SLICE;
+			commandCache = new CommandCache();
+
+			stopCommandAct = commandBar->addAction("Stop");
+			stopCommandAct->setIcon(QIcon::fromTheme("process-stop"));
+			stopCommandAct->setToolTip("Stop the running command");
+			stopCommandAct->setEnabled(false);
+			connect(stopCommandAct, &QAction::triggered, this, &StudioWindow::stopCommand);
+
 			addToolBar(Qt::BottomToolBarArea, commandBar);
 			// END COMMAND BAR
 
@@ -380,6 +475,12 @@ namespace OB{
 		void StudioWindow::newInstance(){
 			OBEngine* eng = new OBEngine();
 			StudioGLWidget* glWidget = new StudioGLWidget(eng);
+			glWidget->getUndoStack()->setMemoryLimit(undoMemoryLimit);
+			glWidget->getOutputLog()->setCapacity(outputLimit);
+			glWidget->getOutputLog()->setRateLimit(outputRateLimit);
+			if(logToFile){
+				glWidget->setLogFile(new LogFileSink(LogFileSink::newLogPath(), logFileSize, logFileCount, logFileCompress));
+			}
 
 			int tabIdx = tabWidget->addTab(glWidget, "Game");
 			QTabBar* tabBar = tabWidget->tabBar();
@@ -398,6 +499,12 @@ namespace OB{
 			tabChanged();
 
 			cmdBar->lineEdit()->setDisabled(false);
+
+			updateTickThreads();
+
+			if(scheduler){
+				scheduler->wake();
+			}
 		}
 
 		void StudioWindow::commandBarReturn(){
@@ -406,41 +513,76 @@ namespace OB{
 
 			sendOutput("> " + text);
 
-			OB::OBEngine* eng = getCurrentEngine();
-			if(!eng){
+			StudioGLWidget* gW = getCurrentGLWidget(getCurrentEngine());
+			if(!gW){
 				return;
 			}
 
-			lua_State* gL = eng->getGlobalLuaState();
-			if(!gL){
-				// Prevents segfaults when commands are run before initialization
+			bool cacheHit = false;
+			if(!gW->startCommand(text, commandCache, &cacheHit)){
+				updateCommandState();
 				return;
 			}
 
-			lua_State* L = Lua::initThread(gL);
-			Lua::setGetsPaused(L, false);
-			Lua::setDMBound(L, false);
+			// Before anything the command prints
+			sendOutput(QString("Bytecode cache %1 (%2 hits, %3 misses)").arg(cacheHit ? "hit" : "miss").arg(commandCache->getHits()).arg(commandCache->getMisses()), QColor(128, 128, 128));
 
-			int s = luaL_loadstring(L, text.toStdString().c_str());
-			if(s == 0){
-				s = lua_resume(L, NULL, 0);
-			}
+			// Short commands finish right here, long ones carry on a
+			// slice per frame in tickEngines()
+			gW->stepCommand(commandTimeSlice);
+			updateCommandState();
+		}
 
-			if(s != 0 && s != LUA_YIELD){
-				Lua::handle_errors(L);
-				Lua::close_state(L);
-			}
-			if(s == LUA_OK){
-				Lua::close_state(L);
+		void StudioWindow::stopCommand(){
+			StudioGLWidget* gW = getCurrentGLWidget(getCurrentEngine());
+			if(!gW || !gW->isRunningCommand()){
+				return;
 			}
+
+			gW->stopCommand();
+			sendOutput("Command stopped.");
+			updateCommandState();
+		}
+
+		void StudioWindow::setCommandTimeSlice(int ms){
+			commandTimeSlice = qMax(1, ms);
+		}
+
+		void StudioWindow::updateCommandState(){
+			StudioGLWidget* gW = dynamic_cast<StudioGLWidget*>(curTab);
+			bool running = gW && gW->isRunningCommand();
+
+			stopCommandAct->setEnabled(running);
+			cmdBar->lineEdit()->setDisabled(!gW || running || gW->isBusy());
 		}
 
 		void StudioWindow::update_toolbar_usability(){
+			updateUndoActions();
+
 			StudioGLWidget* gW = getCurrentGLWidget(getCurrentEngine());
 			if(!gW){
 				return;
 			}
-			std::vector<shared_ptr<Instance::Instance>> selectedInstances = gW->selectedInstances;
+
+			if(gW->isBusy()){
+				// Nothing touches the engine until it's ours again
+				cutAction->setEnabled(false);
+				copyAction->setEnabled(false);
+				pasteAction->setEnabled(false);
+				duplicateAction->setEnabled(false);
+				deleteAction->setEnabled(false);
+				renameAction->setEnabled(false);
+				selectChildrenAct->setEnabled(false);
+				groupAct->setEnabled(false);
+				ungroupAct->setEnabled(false);
+				insertPartAct->setEnabled(false);
+				insertFromFileAct->setEnabled(false);
+				basicObjectsMenu->setEnabled(false);
+				basicObjects->setEnabled(false);
+				return;
+			}
+
+			SelectionSnapshot selectedInstances = gW->selectedInstances.snapshot();
 
 			const int numSelected = selectedInstances.size();
 			if(numSelected > 0){
@@ -566,28 +708,156 @@ namespace OB{
 			return NULL;
 		}
 
-		void StudioWindow::tickEngines(){
+		bool StudioWindow::tickEngines(){
+			bool commandDone = false;
+			bool activity = false;
+
 			int numTabs = tabWidget->count();
 			for(int i = 0; i < numTabs; i++){
 				StudioTabWidget* tw = (StudioGLWidget*)tabWidget->widget(i);
 				StudioGLWidget* gW = NULL;
 				if((gW = dynamic_cast<StudioGLWidget*>(tw))){
-					OBEngine* eng = gW->getEngine();
-					if(eng){
-						eng->tick();
+					// Whatever was printed since last frame goes out at once
+					activity |= gW->flushOutput();
+
+					if(gW->isLoading()){
+						// Nothing ticks while loading. Once the loader lets
+						// go of the engine, what it built is handed to the
+						// explorer a batch at a time.
+						bool wasHeld = gW->holdsEngine();
+						if(wasHeld || gW->tryLockEngine()){
+							gW->drainUiQueue(OB_STUDIO_LOAD_PUBLISH_BATCH);
+							activity |= gW->flushChanges();
+							if(!wasHeld && tw != curTab){
+								gW->unlockEngine();
+							}
+						}
+					}else if(gW->isBusy()){
+						// A save has the engine, skip this tab for now
+						continue;
+					}else if(gW->hasTickThread()){
+						// We already hold the current engine. Background
+						// engines are only touched if they're between
+						// ticks, otherwise their updates wait a frame.
+						if(tw == curTab){
+							commandDone |= gW->stepCommand(commandTimeSlice);
+							activity |= gW->drainUiQueue() > 0;
+							activity |= gW->flushChanges();
+						}else if(gW->tryLockEngine()){
+							commandDone |= gW->stepCommand(commandTimeSlice);
+							activity |= gW->drainUiQueue() > 0;
+							activity |= gW->flushChanges();
+							gW->unlockEngine();
+						}
+					}else{
+						if(gW->tickDue()){
+							OBEngine* eng = gW->getEngine();
+							if(eng){
+								eng->tick();
+							}
+						}
+						commandDone |= gW->stepCommand(commandTimeSlice);
+						activity |= gW->flushChanges();
+					}
+				}
+			}
+
+			if(commandDone){
+				updateCommandState();
+			}
+
+			if(outputFilter->isActive()){
+				updateOutputMatches();
+			}
+
+			return activity || commandDone;
+		}
+
+		// Anything that has to keep going while nobody is touching
+		// the window
+		bool StudioWindow::hasActiveWork(){
+			int numTabs = tabWidget->count();
+			for(int i = 0; i < numTabs; i++){
+				StudioGLWidget* gW = dynamic_cast<StudioGLWidget*>(tabWidget->widget(i));
+				if(gW && (gW->isLoading() || gW->isSaving() || gW->isRunningCommand())){
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void StudioWindow::updateTickThreads(){
+			bool threaded = scheduler && scheduler->isThreadedTicks();
+
+			int numTabs = tabWidget->count();
+			for(int i = 0; i < numTabs; i++){
+				StudioGLWidget* gW = dynamic_cast<StudioGLWidget*>(tabWidget->widget(i));
+				if(gW){
+					if(threaded){
+						gW->startTickThread();
+					}else{
+						gW->stopTickThread();
 					}
 				}
 			}
+		}
 
+		void StudioWindow::renderEngines(){
 			if(curTab){
 				if(StudioGLWidget* gW = dynamic_cast<StudioGLWidget*>(curTab)){
-				    gW->do_render();
+					// Not ours while a loader has it
+					if(gW->holdsEngine()){
+						gW->do_render();
+					}
 				}
 			}
 		}
 
+		void StudioWindow::updateFrameStats(){
+			if(!scheduler){
+				return;
+			}
+
+			FrameStats stats = scheduler->getStats();
+
+			QString statStr;
+			if(scheduler->isIdle()){
+				statStr = "Idle";
+			}else{
+				double fps = 0;
+				if(stats.frameInterval > 0){
+					fps = 1000.0 / stats.frameInterval;
+				}
+				statStr = QString("%1 FPS | tick %2 ms | render %3 ms | input %4 ms")
+					.arg(fps, 0, 'f', 1)
+					.arg(stats.tickTime, 0, 'f', 2)
+					.arg(stats.renderTime, 0, 'f', 2)
+					.arg(stats.inputLatency, 0, 'f', 1);
+			}
+
+			frameStatsLabel->setText(statStr);
+		}
+
+		void StudioWindow::setExplorerModel(InstanceTreeModel* model, QItemSelectionModel* selection){
+			// setModel() always makes a new selection model owned by the
+			// view. Tabs bring their own, so those get thrown away.
+			QItemSelectionModel* oldSelection = explorer->selectionModel();
+			explorer->setModel(model);
+			if(oldSelection && oldSelection->parent() == explorer){
+				delete oldSelection;
+			}
+
+			if(selection){
+				QItemSelectionModel* viewSelection = explorer->selectionModel();
+				explorer->setSelectionModel(selection);
+				delete viewSelection;
+			}
+		}
+
 		void StudioWindow::selectionChanged(){
-			QList<QTreeWidgetItem*> selectedItems = explorer->selectedItems();
+			if(updatingSelection){
+				return;
+			}
 
 			OBEngine* eng = getCurrentEngine();
 			StudioGLWidget* sW = getCurrentGLWidget(eng);
@@ -595,19 +865,23 @@ namespace OB{
 				return;
 			}
 
+			InstanceTreeModel* im = explorer->instanceModel();
+			if(!im){
+				return;
+			}
+
+			QModelIndexList selectedIdxs = explorer->selectionModel()->selectedIndexes();
+
 			sW->selectedInstances.clear();
 
-			for(int i = 0; i < selectedItems.size(); i++){
-				InstanceTreeItem* srcItem = dynamic_cast<InstanceTreeItem*>(selectedItems[i]);
-				if(srcItem){
-					shared_ptr<Instance::Instance> instPtr = srcItem->GetInstance();
-					if(instPtr){
-						sW->selectedInstances.push_back(instPtr);
-					}
+			for(int i = 0; i < selectedIdxs.size(); i++){
+				shared_ptr<Instance::Instance> instPtr = im->instanceAt(selectedIdxs[i]);
+				if(instPtr){
+					sW->selectedInstances.add(instPtr);
 				}
 			}
 
-			properties->updateSelection(sW->selectedInstances);
+			properties->updateSelection(sW->selectedInstances.snapshot());
 			update_toolbar_usability();
 
 			shared_ptr<Instance::DataModel> dm = eng->getDataModel();
@@ -620,52 +894,27 @@ namespace OB{
 		}
 
 		void StudioWindow::updateSelectionFromLua(OBEngine* eng){
-			const QSignalBlocker sigBlock(explorer);
-
 			StudioGLWidget* gW = getCurrentGLWidget(eng);
 			if(!gW){
 				return;
 			}
 
-			std::vector<shared_ptr<Instance::Instance>> newSelection = gW->selectedInstances;
+			InstanceTreeModel* im = gW->explorerModel;
+			if(!im || explorer->instanceModel() != im){
+				return;
+			}
 
-			explorer->clearSelection();
-			for(int i = 0; i < newSelection.size(); i++){
-				shared_ptr<Instance::Instance> inst = gW->selectedInstances.at(i);
-				if(inst){
-					shared_ptr<Instance::Instance> parInst = inst->getParent();
-
-					InstanceTreeItem* ti = gW->treeItemMap.value(inst);
-					if(ti){
-						InstanceTreeItem* pTi = (InstanceTreeItem*)ti->parent();
-						if(pTi){
-							if(pTi->GetInstance() != parInst){
-								std::vector<shared_ptr<Type::VarWrapper>> argVector({make_shared<Type::VarWrapper>(inst)});
-								gW->instance_child_removed_evt(argVector, pTi);
-								if(parInst){
-									InstanceTreeItem* tiParent = gW->treeItemMap.value(parInst);
-									if(tiParent){
-										gW->instance_child_added_evt(argVector, tiParent);
-									}
-								}
-							}
-						}
-						ti->setSelected(true);
-					}else{
-						if(parInst){
-							InstanceTreeItem* tiParent = gW->treeItemMap.value(parInst);
-							if(tiParent){
-								std::vector<shared_ptr<Type::VarWrapper>> argVector({make_shared<Type::VarWrapper>(inst)});
-								gW->instance_child_added_evt(argVector, tiParent);
-								ti = gW->treeItemMap.value(inst);
-								if(ti){
-									ti->setSelected(true);
-								}
-							}
-						}
-					}
+			QItemSelection newSelection;
+			for(size_t i = 0; i < gW->selectedInstances.size(); i++){
+				QModelIndex idx = im->indexOf(gW->selectedInstances.at(i));
+				if(idx.isValid()){
+					newSelection.select(idx, idx);
 				}
 			}
+
+			updatingSelection = true;
+			explorer->selectionModel()->select(newSelection, QItemSelectionModel::ClearAndSelect);
+			updatingSelection = false;
 		}
 
 		void StudioWindow::populateBasicObjects(){
@@ -689,8 +938,6 @@ namespace OB{
 			}
 		}
 
-		// Do I think the use of HTML here is horrible? Yes.
-		// Am I going to do something about it in the near future? Probably not.
 		void StudioWindow::sendOutput(QString msg){
 			StudioGLWidget* gW = getCurrentGLWidget(getCurrentEngine());
 			if(gW){
@@ -705,20 +952,14 @@ namespace OB{
 			}
 		}
 
-		void StudioWindow::cutSelection(){
-			StudioGLWidget* sW = getCurrentGLWidget(getCurrentEngine());
-			if(!sW){
-				return;
-			}
-
-			std::vector<shared_ptr<Instance::Instance>> selectedInstances = sW->selectedInstances;
+		static bool ob_studio_is_protected(shared_ptr<Instance::Instance> inst){
+			shared_ptr<const ClassSchema> schema = ClassSchema::forInstance(inst);
+			return schema && schema->isProtected();
+		}
 
-			if(selectedInstances.size() == 1){
-				shared_ptr<Instance::Instance> inst = selectedInstances.at(0);
-				if(inst){
-					// TODO
-				}
-			}
+		void StudioWindow::cutSelection(){
+			copySelection();
+			removeSelection("Cut");
 		}
 
 		void StudioWindow::copySelection(){
@@ -727,28 +968,52 @@ namespace OB{
 				return;
 			}
 
-			std::vector<shared_ptr<Instance::Instance>> selectedInstances = sW->selectedInstances;
+			SelectionSnapshot selectedInstances = sW->selectedInstances.snapshot();
 
-			if(selectedInstances.size() == 1){
-				shared_ptr<Instance::Instance> inst = selectedInstances.at(0);
-				if(inst){
-					// TODO
-				}
+			std::vector<shared_ptr<Instance::Instance>> roots = InstanceMimeData::copyableRoots(selectedInstances.list());
+			if(roots.empty()){
+				return;
 			}
+
+			// Serialized once this returns, see InstanceMimeData
+			QApplication::clipboard()->setMimeData(new InstanceMimeData(sW, roots));
 		}
 
 		void StudioWindow::pasteIntoSelection(){
-			StudioGLWidget* sW = getCurrentGLWidget(getCurrentEngine());
+			OBEngine* eng = getCurrentEngine();
+			StudioGLWidget* sW = getCurrentGLWidget(eng);
 			if(!sW){
 				return;
 			}
 
-			std::vector<shared_ptr<Instance::Instance>> selectedInstances = sW->selectedInstances;
+			SelectionSnapshot selectedInstances = sW->selectedInstances.snapshot();
 
 			if(selectedInstances.size() == 1){
 				shared_ptr<Instance::Instance> inst = selectedInstances.at(0);
 				if(inst){
-					// TODO
+					const QMimeData* mime = QApplication::clipboard()->mimeData();
+					if(!mime || !mime->hasFormat(OB_STUDIO_INSTANCE_MIME_TYPE)){
+						return;
+					}
+
+					QByteArray payload = mime->data(OB_STUDIO_INSTANCE_MIME_TYPE);
+
+					QString error;
+					std::vector<shared_ptr<Instance::Instance>> pasted;
+					if(!BinaryPlace::loadInto(eng, NULL, payload.constData(), payload.size(), &error, &pasted)){
+						statusBar()->showMessage("Paste failed: " + error);
+						return;
+					}
+
+					// Built detached, so the explorer only sees the roots
+					// arrive, all at once
+					UndoCommand* cmd = new UndoCommand("Paste");
+					sW->reparent(pasted, inst, cmd);
+					sW->recordUndo(cmd);
+
+					sW->selectedInstances.assign(pasted);
+					updateSelectionFromLua(eng);
+					update_toolbar_usability();
 				}
 			}
 		}
@@ -759,52 +1024,87 @@ namespace OB{
 				return;
 			}
 
-		    std::vector<shared_ptr<Instance::Instance>> selectedInstances = sW->selectedInstances;
+		    SelectionSnapshot selectedInstances = sW->selectedInstances.snapshot();
 
 			if(selectedInstances.size() > 0){
-				for(int i = 0; i < selectedInstances.size(); i++){
+				// Protected instances go first, so they can't cover a
+				// selected descendant that can be duplicated
+				std::vector<shared_ptr<Instance::Instance>> candidates;
+				for(size_t i = 0; i < selectedInstances.size(); i++){
 					shared_ptr<Instance::Instance> inst = selectedInstances.at(i);
-					if(inst){
-						// Let's make a few classes safe..
-						std::string className = inst->getClassName();
-						if(className != "Workspace" &&
-						   className != "Lighting" &&
-						   className != "ContentProvider" &&
-						   className != "LogService" &&
-						   className != "RunService" &&
-						   className != "ReplicatedFirst"){
-							shared_ptr<Instance::Instance> clonedInst = inst->Clone();
-						    clonedInst->setParent(inst->getParent(), false);
+					if(inst && !ob_studio_is_protected(inst)){
+						candidates.push_back(inst);
+					}
+				}
+
+				// A selected instance inside another selected one is
+				// already duplicated along with it
+				std::vector<shared_ptr<Instance::Instance>> roots = InstanceMimeData::copyableRoots(candidates);
+
+				std::vector<shared_ptr<Instance::Instance>> clones;
+				clones.reserve(roots.size());
+				for(size_t i = 0; i < roots.size(); i++){
+					clones.push_back(roots[i]->Clone());
+				}
+
+				// Every clone goes in at once
+				UndoCommand* cmd = new UndoCommand("Duplicate");
+				{
+					BulkUpdate bulk(sW);
+
+					for(size_t i = 0; i < clones.size(); i++){
+						if(clones[i]){
+							shared_ptr<Instance::Instance> par = roots[i]->getParent();
+							try{
+								clones[i]->setParent(par, true);
+							}catch(OBException* ex){
+								continue;
+							}
+							cmd->addReparent(clones[i], NULL, par);
 						}
 					}
 				}
+				sW->recordUndo(cmd);
 			}
 		}
 
 		void StudioWindow::deleteSelection(){
+			removeSelection("Delete");
+		}
+
+		void StudioWindow::removeSelection(QString undoText){
 			StudioGLWidget* sW = getCurrentGLWidget(getCurrentEngine());
 			if(!sW){
 				return;
 			}
 
-			std::vector<shared_ptr<Instance::Instance>> selectedInstances = sW->selectedInstances;
+			SelectionSnapshot selectedInstances = sW->selectedInstances.snapshot();
 
 			if(selectedInstances.size() > 0){
-				for(int i = 0; i < selectedInstances.size(); i++){
-					shared_ptr<Instance::Instance> inst = selectedInstances.at(i);
-					if(inst){
-						// Let's make a few classes safe..
-						std::string className = inst->getClassName();
-						if(className != "Workspace" &&
-						   className != "Lighting" &&
-						   className != "ContentProvider" &&
-						   className != "LogService" &&
-						   className != "RunService" &&
-						   className != "ReplicatedFirst"){
-							inst->Destroy();
+				UndoCommand* cmd = new UndoCommand(undoText);
+				{
+					BulkUpdate bulk(sW);
+
+					for(int i = 0; i < selectedInstances.size(); i++){
+						shared_ptr<Instance::Instance> inst = selectedInstances.at(i);
+						if(inst){
+							// Let's make a few classes safe..
+							if(!ob_studio_is_protected(inst)){
+								// Only unparented, the undo history keeps it
+								// around in case it's wanted back and destroys
+								// it once the command is dropped
+								shared_ptr<Instance::Instance> oPar = inst->getParent();
+								try{
+									inst->setParent(NULL, true);
+								}catch(OBException* ex){
+									continue;
+								}
+								cmd->addReparent(inst, oPar, NULL);
+							}
 						}
 					}
 				}
+				sW->recordUndo(cmd);
 			}
 		}
 
@@ -814,26 +1114,64 @@ namespace OB{
 				return;
 			}
 
-			std::vector<shared_ptr<Instance::Instance>> selectedInstances = sW->selectedInstances;
+			SelectionSnapshot selectedInstances = sW->selectedInstances.snapshot();
 
 			if(selectedInstances.size() == 1){
 				shared_ptr<Instance::Instance> inst = selectedInstances.at(0);
 				if(inst){
 					// Let's make a few classes safe..
-					std::string className = inst->getClassName();
-					if(className != "Workspace" &&
-					   className != "Lighting" &&
-					   className != "ContentProvider" &&
-					   className != "LogService" &&
-					   className != "RunService" &&
-					   className != "ReplicatedFirst"){
-						QTreeWidgetItem* selectedItem = explorer->selectedItems().first();
-					    explorer->editItem(selectedItem);
+					if(!ob_studio_is_protected(inst)){
+						InstanceTreeModel* im = explorer->instanceModel();
+						if(im){
+							explorer->edit(im->indexOf(inst));
+						}
 					}
 				}
 			}
 		}
 
+		void StudioWindow::tabContextMenu(const QPoint &pos){
+			QTabBar* tabBar = tabWidget->tabBar();
+
+			int tabIdx = tabBar->tabAt(pos);
+			if(tabIdx < 0){
+				return;
+			}
+
+			StudioGLWidget* gW = dynamic_cast<StudioGLWidget*>(tabWidget->widget(tabIdx));
+			if(!gW){
+				return;
+			}
+
+			QMenu tabMenu;
+			QMenu* policyMenu = tabMenu.addMenu("When in background");
+			QActionGroup* policyGroup = new QActionGroup(policyMenu);
+
+			struct{
+				const char* label;
+				TickPolicy policy;
+			} policies[] = {
+				{"Use default", TickPolicy::Default},
+				{"Full rate", TickPolicy::Full},
+				{"Reduced rate", TickPolicy::Reduced},
+				{"Paused", TickPolicy::Paused}
+			};
+
+			for(int i = 0; i < 4; i++){
+				QAction* policyAct = policyMenu->addAction(policies[i].label);
+				policyAct->setCheckable(true);
+				policyAct->setChecked(gW->getBackgroundTickPolicy() == policies[i].policy);
+				policyGroup->addAction(policyAct);
+
+				TickPolicy policy = policies[i].policy;
+				connect(policyAct, &QAction::triggered, [gW, policy](){
+					gW->setBackgroundTickPolicy(policy);
+				});
+			}
+
+			tabMenu.exec(tabBar->mapToGlobal(pos));
+		}
+
 		void StudioWindow::explorerContextMenu(const QPoint &pos){
 			if(explorerPopupMenu){
 			    explorerPopupMenu->popup(explorer->mapToGlobal(pos));
@@ -873,9 +1211,17 @@ namespace OB{
 		void StudioWindow::tabChanged(){
 			if(curTab){
 				curTab->remove_focus();
+
+				if(StudioGLWidget* gW = dynamic_cast<StudioGLWidget*>(curTab)){
+					gW->unlockEngine();
+				}
 			}
 			curTab = (StudioTabWidget*)tabWidget->currentWidget();
 			if(curTab){
+				if(StudioGLWidget* gW = dynamic_cast<StudioGLWidget*>(curTab)){
+					gW->acquireEngine();
+				}
+
 				curTab->gain_focus();
 			}
 
@@ -884,6 +1230,8 @@ namespace OB{
 				saveAction->setEnabled(true);
 				saveAsAction->setEnabled(true);
 			}
+
+			updatePlaceProgress();
 		}
 
 		void StudioWindow::groupSelection(){
@@ -893,7 +1241,7 @@ namespace OB{
 				return;
 			}
 
-			std::vector<shared_ptr<Instance::Instance>> selectedInstances = sW->selectedInstances;
+			SelectionSnapshot selectedInstances = sW->selectedInstances.snapshot();
 
 			shared_ptr<Instance::Instance> selectedInst = selectedInstances.at(0);
 			if(selectedInst){
@@ -901,28 +1249,24 @@ namespace OB{
 
 				shared_ptr<Instance::Instance> newModel = ClassFactory::create("Model", eng);
 				if(newModel){
-					newModel->setParent(newPar, true);
-
-					std::vector<shared_ptr<Instance::Instance>> toGroup = selectedInstances;
-					for(int i = 0; i < toGroup.size(); i++){
-						shared_ptr<Instance::Instance> kI = toGroup.at(i);
-						if(kI){
-							std::vector<shared_ptr<Type::VarWrapper>> argVector({make_shared<Type::VarWrapper>(kI)});
-
-							shared_ptr<Instance::Instance> oPar = kI->getParent();
-							if(oPar){
-								InstanceTreeItem* pTi = sW->treeItemMap.value(oPar);
-								if(pTi){
-									sW->instance_child_removed_evt(argVector, pTi);
-								}
-							}
-
-							kI->setParent(newModel, false);
+					UndoCommand* cmd = new UndoCommand("Group");
+					{
+						BulkUpdate bulk(sW);
+
+						try{
+							newModel->setParent(newPar, true);
+						}catch(OBException* ex){
+							delete cmd;
+							return;
 						}
+						cmd->addReparent(newModel, NULL, newPar);
+
+						sW->reparent(selectedInstances.list(), newModel, cmd);
 					}
+					sW->recordUndo(cmd);
 
 					sW->selectedInstances.clear();
-					sW->selectedInstances.push_back(newModel);
+					sW->selectedInstances.add(newModel);
 					updateSelectionFromLua(eng);
 
 					update_toolbar_usability();
@@ -951,21 +1295,23 @@ namespace OB{
 			}
 
 			if(newPar){
+				UndoCommand* cmd = new UndoCommand("Ungroup");
+
 				std::vector<shared_ptr<Instance::Instance>> allKids = selectedInst->GetChildren();
-				for(int i = 0; i < allKids.size(); i++){
-					shared_ptr<Instance::Instance> kI = allKids.at(i);
-					if(kI){
-						kI->setParent(newPar, true);
-					}
-				}
-				selectedInst->Destroy();
-				InstanceTreeItem* pti = gW->treeItemMap.value(newPar);
-				if(pti){
-					std::vector<shared_ptr<Type::VarWrapper>> argVector({make_shared<Type::VarWrapper>(selectedInst)});
-					gW->instance_child_removed_evt(argVector, pti);
+				{
+					BulkUpdate bulk(gW);
+
+					gW->reparent(allKids, newPar, cmd);
+
+					// Kept for undo, destroyed when the command is dropped
+					try{
+						selectedInst->setParent(NULL, true);
+						cmd->addReparent(selectedInst, newPar, NULL);
+					}catch(OBException* ex){}
 				}
+				gW->recordUndo(cmd);
 
-				gW->selectedInstances = allKids;
+				gW->selectedInstances.assign(allKids);
 				updateSelectionFromLua(eng);
 				update_toolbar_usability();
 			}
@@ -982,7 +1328,7 @@ namespace OB{
 			if(selectedInst){
 				std::vector<shared_ptr<Instance::Instance>> allKids = selectedInst->GetChildren();
 				if(allKids.size() > 0){
-					gW->selectedInstances = allKids;
+					gW->selectedInstances.assign(allKids);
 					updateSelectionFromLua(eng);
 					update_toolbar_usability();
 				}
@@ -1032,6 +1378,15 @@ namespace OB{
 				return;
 			}
 
+			if(gW->isSaving()){
+				// Autosaves are quick, let it finish rather than make
+				// the user try again
+				if(!gW->getSaver()->isAutosave()){
+					return;
+				}
+				gW->stopSaver();
+			}
+
 			if(gW->fileOpened.length() > 0){
 				// We use this instead of Save(file) to allow saving
 				// to remote locations such as network drives/webdav
@@ -1044,24 +1399,13 @@ namespace OB{
 					return;
 				}
 
-				std::string strToWrite = serializer->SaveInMemory_XML();
-				if(strToWrite.length() == 0){
-					QString errMsg = "Failed to serialize game.";
-					statusBar()->showMessage(errMsg);
-					QMessageBox::critical(this, "Error", errMsg);
-				}else{
-					QFile file(gW->fileOpened);
-					std::cout << "Saving to " << gW->fileOpened.toStdString() << std::endl;
-					if(file.open(QIODevice::WriteOnly)){
-						QTextStream stream(&file);
-						stream << QString(strToWrite.c_str()) << flush;
-						statusBar()->showMessage("Saved.");
-					}else{
-						QString errMsg = "Failed to open file";
-						statusBar()->showMessage(errMsg);
-						QMessageBox::critical(this, "Error", errMsg);
-					}
-				}
+				std::cout << "Saving to " << gW->fileOpened.toStdString() << std::endl;
+				statusBar()->showMessage("Saving...");
+
+				gW->savePlace(gW->fileOpened);
+				placeTimer->start();
+
+				updatePlaceProgress();
 			}else{
 				// No file open
 				saveAsAct();
@@ -1080,7 +1424,21 @@ namespace OB{
 			fileDia->setDefaultSuffix("obgx");
 			fileDia->setFileMode(QFileDialog::AnyFile);
 			fileDia->setFilter(QDir::Files | QDir::Writable);
-			fileDia->setNameFilter("OpenBlox Game (*.obgx)");
+
+			QStringList nameFilters;
+			nameFilters << "OpenBlox Game (*.obgx)" << "OpenBlox Binary Game (*." OB_STUDIO_BINARY_PLACE_SUFFIX ")";
+			fileDia->setNameFilters(nameFilters);
+			connect(fileDia, &QFileDialog::filterSelected, [fileDia](const QString& filter){
+				if(filter.contains("*." OB_STUDIO_BINARY_PLACE_SUFFIX)){
+					fileDia->setDefaultSuffix(OB_STUDIO_BINARY_PLACE_SUFFIX);
+				}else{
+					fileDia->setDefaultSuffix("obgx");
+				}
+			});
+			if(QFileInfo(gW->fileOpened).suffix() == OB_STUDIO_BINARY_PLACE_SUFFIX){
+				fileDia->selectNameFilter(nameFilters[1]);
+				fileDia->setDefaultSuffix(OB_STUDIO_BINARY_PLACE_SUFFIX);
+			}
 
 			if(fileDia->exec()){
 				QList<QUrl> selected = fileDia->selectedUrls();
@@ -1102,29 +1460,277 @@ namespace OB{
 				if(!gW){
 					return;
 				}
-				gW->fileOpened = toOpen;
-				shared_ptr<OBSerializer> serializer = eng->getSerializer();
-				if(!serializer){
-					// This should never happen
-					statusBar()->showMessage("No serialization support.");
-					// This error message is, of course, totally bogus.
-					QMessageBox::critical(this, "Error", "Serialization failed due to lack of binary executable data.");
-					return;
+
+				statusBar()->showMessage("Loading " + QFileInfo(toOpen).fileName() + "...");
+
+				gW->loadPlace(toOpen);
+				placeTimer->start();
+
+				updatePlaceProgress();
+			}
+		}
+
+		void StudioWindow::updatePlaceProgress(){
+			bool anyRunning = false;
+
+			int numTabs = tabWidget->count();
+			for(int i = 0; i < numTabs; i++){
+				StudioGLWidget* gW = dynamic_cast<StudioGLWidget*>(tabWidget->widget(i));
+				if(!gW){
+					continue;
 				}
 
-				QString buf;
-				QFile f(toOpen);
-				if(!f.open(QFile::ReadOnly | QFile::Text)){
-					statusBar()->showMessage("Could not open file.");
-					// This error message is, of course, totally bogus.
-					QMessageBox::critical(this, "Error", "Failed to open file (can't read?)");
-					return;
+				PlaceTask* task = gW->getLoader();
+				bool loading = task != NULL;
+				if(!task){
+					task = gW->getSaver();
+				}
+				if(!task){
+					continue;
+				}
+
+				PlaceTask::State state = task->getState();
+				QString errMsg = task->getError();
+				bool autosave = !loading && gW->getSaver()->isAutosave();
+
+				bool finished = loading ? gW->finishLoad() : gW->finishSave();
+				if(!finished){
+					anyRunning = true;
+					continue;
+				}
+
+				if(autosave){
+					// Nobody asked for it, so only say something if
+					// it went wrong
+					if(state == PlaceTask::State::Failed){
+						statusBar()->showMessage("Autosave failed: " + errMsg);
+					}
+					continue;
+				}
+
+				switch(state){
+					case PlaceTask::State::Done: {
+						statusBar()->showMessage(loading ? "Loaded." : "Saved.");
+						break;
+					}
+					case PlaceTask::State::Canceled: {
+						statusBar()->showMessage("Operation canceled.");
+						break;
+					}
+					default: {
+						statusBar()->showMessage(errMsg);
+						QMessageBox::critical(this, "Error", errMsg);
+						break;
+					}
+				}
+			}
+
+			StudioGLWidget* gW = dynamic_cast<StudioGLWidget*>(curTab);
+			PlaceTask* task = NULL;
+			if(gW){
+				task = gW->getLoader();
+				if(!task && gW->getSaver() && !gW->getSaver()->isAutosave()){
+					task = gW->getSaver();
+				}
+			}
+
+			if(task){
+				// A finished loader is still handing instances over
+				int progress = task->isDone() ? -1 : task->getProgress();
+				if(progress < 0){
+					placeProgress->setRange(0, 0);
+				}else{
+					placeProgress->setRange(0, 100);
+					placeProgress->setValue(progress);
+				}
+				placeCancelButton->setEnabled(task->canCancel());
+			}
+
+			placeProgress->setVisible(task != NULL);
+			placeCancelButton->setVisible(task != NULL);
+
+			bool busy = gW && gW->isBusy();
+			explorer->setEnabled(!busy);
+			updateCommandState();
+			saveAction->setEnabled(gW && !task);
+			saveAsAction->setEnabled(gW && !task);
+
+			if(gW){
+				update_toolbar_usability();
+			}
+
+			if(!anyRunning){
+				placeTimer->stop();
+			}
+		}
+
+		// 0 turns autosave off
+		void StudioWindow::setAutosaveInterval(int secs){
+			if(secs > 0){
+				autosaveTimer->start(secs * 1000);
+			}else{
+				autosaveTimer->stop();
+			}
+		}
+
+		void StudioWindow::autosaveAll(){
+			bool snapshotStarted = false;
+
+			int numTabs = tabWidget->count();
+			for(int i = 0; i < numTabs; i++){
+				StudioGLWidget* gW = dynamic_cast<StudioGLWidget*>(tabWidget->widget(i));
+				if(gW && gW->autosave()){
+					snapshotStarted = true;
+				}
+			}
+
+			if(snapshotStarted){
+				placeTimer->start();
+			}
+		}
+
+		void StudioWindow::setUndoMemoryLimit(size_t bytes){
+			undoMemoryLimit = bytes;
+
+			int numTabs = tabWidget->count();
+			for(int i = 0; i < numTabs; i++){
+				StudioGLWidget* gW = dynamic_cast<StudioGLWidget*>(tabWidget->widget(i));
+				if(gW){
+					gW->getUndoStack()->setMemoryLimit(bytes);
+				}
+			}
+		}
+
+		void StudioWindow::setOutputLimit(int lines){
+			outputLimit = qMax(1, lines);
+
+			int numTabs = tabWidget->count();
+			for(int i = 0; i < numTabs; i++){
+				StudioGLWidget* gW = dynamic_cast<StudioGLWidget*>(tabWidget->widget(i));
+				if(gW){
+					gW->getOutputLog()->setCapacity(outputLimit);
+				}
+			}
+		}
+
+		void StudioWindow::setOutputRateLimit(int perSecond){
+			outputRateLimit = qMax(0, perSecond);
+
+			int numTabs = tabWidget->count();
+			for(int i = 0; i < numTabs; i++){
+				StudioGLWidget* gW = dynamic_cast<StudioGLWidget*>(tabWidget->widget(i));
+				if(gW){
+					gW->getOutputLog()->setRateLimit(outputRateLimit);
+				}
+			}
+		}
+
+		void StudioWindow::setLogToFile(bool enabled, qint64 maxBytes, int maxFiles, bool compress){
+			logToFile = enabled;
+			logFileSize = maxBytes;
+			logFileCount = maxFiles;
+			logFileCompress = compress;
+
+			// Open tabs start a new file with the new limits
+			int numTabs = tabWidget->count();
+			for(int i = 0; i < numTabs; i++){
+				StudioGLWidget* gW = dynamic_cast<StudioGLWidget*>(tabWidget->widget(i));
+				if(gW){
+					if(enabled){
+						gW->setLogFile(new LogFileSink(LogFileSink::newLogPath(), maxBytes, maxFiles, compress));
+					}else{
+						gW->setLogFile(NULL);
+					}
+				}
+			}
+		}
+
+		void StudioWindow::setOutputLog(OutputLog* log){
+			outputFilter->setLog(log);
+			output->scrollToBottom();
+			updateOutputMatches();
+		}
+
+		void StudioWindow::applyOutputFilter(){
+			int levels = 0;
+			for(int i = 0; i < OB_STUDIO_OUTPUT_LEVELS; i++){
+				if(outputLevelBoxes[i]->isChecked()){
+					levels |= 1 << i;
 				}
-				QTextStream in(&f);
-				buf = in.readAll();
+			}
+
+			outputFilter->setFilter(levels, outputFilterEdit->text(), outputRegexBox->isChecked());
+			output->scrollToBottom();
+			updateOutputMatches();
+		}
 
-				serializer->LoadFromMemory((char*)buf.toStdString().c_str(), buf.size());
+		void StudioWindow::updateOutputMatches(){
+			QString error = outputFilter->getError();
+			if(!error.isEmpty()){
+				outputMatchLabel->setText(tr("Bad regex"));
+				outputMatchLabel->setToolTip(error);
+				return;
 			}
+
+			outputMatchLabel->setToolTip(QString());
+
+			OutputLog* log = outputFilter->getLog();
+			if(!log || !outputFilter->isActive()){
+				outputMatchLabel->setText(QString());
+				return;
+			}
+			outputMatchLabel->setText(tr("%1 of %2").arg(outputFilter->rowCount()).arg(log->rowCount()));
+		}
+
+		void StudioWindow::updateUndoActions(){
+			StudioGLWidget* gW = getCurrentGLWidget(getCurrentEngine());
+			if(!gW || gW->isBusy()){
+				undoAction->setEnabled(false);
+				undoAction->setText("Undo");
+				redoAction->setEnabled(false);
+				redoAction->setText("Redo");
+				return;
+			}
+
+			UndoStack* undoStack = gW->getUndoStack();
+
+			undoAction->setEnabled(undoStack->canUndo());
+			undoAction->setText(undoStack->canUndo() ? "Undo " + undoStack->getUndoText() : QString("Undo"));
+
+			redoAction->setEnabled(undoStack->canRedo());
+			redoAction->setText(undoStack->canRedo() ? "Redo " + undoStack->getRedoText() : QString("Redo"));
+		}
+
+		void StudioWindow::undoAct(){
+			OBEngine* eng = getCurrentEngine();
+			StudioGLWidget* gW = getCurrentGLWidget(eng);
+			if(!gW || gW->isBusy()){
+				return;
+			}
+
+			{
+				BulkUpdate bulk(gW);
+				gW->getUndoStack()->undo();
+			}
+
+			updateSelectionFromLua(eng);
+			update_toolbar_usability();
+		}
+
+		void StudioWindow::redoAct(){
+			OBEngine* eng = getCurrentEngine();
+			StudioGLWidget* gW = getCurrentGLWidget(eng);
+			if(!gW || gW->isBusy()){
+				return;
+			}
+
+			{
+				BulkUpdate bulk(gW);
+				gW->getUndoStack()->redo();
+			}
+
+			updateSelectionFromLua(eng);
+			update_toolbar_usability();
 		}
 
 		void StudioWindow::openGame(){
@@ -1135,7 +1741,7 @@ namespace OB{
 			fileDia->setDefaultSuffix("obgx");
 			fileDia->setFileMode(QFileDialog::AnyFile);
 			fileDia->setFilter(QDir::Files | QDir::Writable);
-			fileDia->setNameFilter("OpenBlox Game (*.obgx)");
+			fileDia->setNameFilter("OpenBlox Game (*.obgx *." OB_STUDIO_BINARY_PLACE_SUFFIX ")");
 
 			if(fileDia->exec()){
 				QList<QUrl> selected = fileDia->selectedUrls();
@@ -1151,7 +1757,63 @@ namespace OB{
 		}
 
 		void StudioWindow::closeEvent(QCloseEvent* evt){
-			//TODO: If unsaved changes exist, ask if user wants to save
+			int numTabs = tabWidget->count();
+
+			QList<StudioGLWidget*> modifiedTabs;
+			for(int i = 0; i < numTabs; i++){
+				StudioGLWidget* gW = dynamic_cast<StudioGLWidget*>(tabWidget->widget(i));
+				if(gW && gW->isModified() && !gW->isLoading()){
+					modifiedTabs.append(gW);
+				}
+			}
+
+			if(!modifiedTabs.isEmpty()){
+				QMessageBox::StandardButton answer = QMessageBox::question(this, "Unsaved Changes", "Some games have unsaved changes. Save them before closing?", QMessageBox::Save | QMessageBox::Discard | QMessageBox::Cancel, QMessageBox::Save);
+				if(answer == QMessageBox::Cancel){
+					evt->ignore();
+					return;
+				}
+
+				if(answer == QMessageBox::Save){
+					for(int i = 0; i < modifiedTabs.size(); i++){
+						StudioGLWidget* gW = modifiedTabs[i];
+						tabWidget->setCurrentWidget(gW);
+
+						saveAct();
+						gW->stopSaver();
+
+						// Canceled the save dialog, or the save failed
+						if(gW->isModified()){
+							statusBar()->showMessage("Close canceled, not everything was saved.");
+							evt->ignore();
+							return;
+						}
+					}
+				}
+			}
+
+			if(scheduler){
+				scheduler->stop();
+			}
+			autosaveTimer->stop();
+
+			for(int i = 0; i < numTabs; i++){
+				StudioGLWidget* gW = dynamic_cast<StudioGLWidget*>(tabWidget->widget(i));
+				if(gW){
+					gW->stopLoader();
+					gW->stopSaver();
+					gW->stopTickThread();
+
+					// Closed on purpose, nothing to recover
+					if(gW->getJournal()){
+						gW->getJournal()->reset();
+					}
+
+					gW->setLogFile(NULL);
+				}
+			}
+			AutosaveJournal::shutdown();
+			LogFileSink::shutdown();
 
 			appSettings->beginGroup("main_window");
 			{
@@ -1164,6 +1826,7 @@ namespace OB{
 			{
 				appSettings->setValue("max_history", cmdBar->maxCount());
 				appSettings->setValue("history", ((QStringListModel*)(cmdBar->model()))->stringList());
+				commandCache->writeSettings(appSettings);
 			}
 			appSettings->endGroup();
 
@@ -23,14 +23,22 @@
 #include <QMainWindow>
 
 #include <QTabWidget>
-#include <QTextEdit>
+#include <QListView>
+#include <QLineEdit>
+#include <QCheckBox>
 #include <QComboBox>
 #include <QSettings>
 #include <QListWidget>
+#include <QLabel>
+#include <QTimer>
+#include <QProgressBar>
+#include <QPushButton>
 
 #include "InstanceTree.h"
 #include "StudioGLWidget.h"
 #include "PropertyTreeWidget.h"
+#include "FrameScheduler.h"
+#include "OutputFilter.h"
 
 #define OB_STUDIO_DEFAULT_PORT 4490
 
@@ -49,7 +57,12 @@ namespace OB{
 			QTabWidget* tabWidget;
 			StudioTabWidget* curTab;
 
-			QTextEdit* output;
+			QListView* output;
+			OutputFilter* outputFilter;
+			QLineEdit* outputFilterEdit;
+			QCheckBox* outputRegexBox;
+			QCheckBox* outputLevelBoxes[OB_STUDIO_OUTPUT_LEVELS];
+			QLabel* outputMatchLabel;
 			InstanceTree* explorer;
 			PropertyTreeWidget* properties;
 			QComboBox* cmdBar;
@@ -61,10 +74,40 @@ namespace OB{
 
 			QSettings* settingsInst;
 
+			bool updatingSelection;
+
+			FrameScheduler* scheduler;
+
+			QLabel* frameStatsLabel;
+			QTimer* frameStatsTimer;
+
+			QProgressBar* placeProgress;
+			QPushButton* placeCancelButton;
+			QTimer* placeTimer;
+
+			QTimer* autosaveTimer;
+
+			size_t undoMemoryLimit;
+
+			int outputLimit;
+			int outputRateLimit;
+
+			bool logToFile;
+			qint64 logFileSize;
+			int logFileCount;
+			bool logFileCompress;
+
+			QAction* stopCommandAct;
+			int commandTimeSlice;
+			CommandCache* commandCache;
+
 			// Actions
 			QAction* saveAction;
 			QAction* saveAsAction;
 
+			QAction* undoAction;
+			QAction* redoAction;
+
 			QAction* cutAction;
 			QAction* copyAction;
 			QAction* pasteAction;
@@ -80,18 +123,43 @@ namespace OB{
 			QMenu* insertObjectMenu;
 			QAction* insertFromFileAct;
 
+			void setExplorerModel(InstanceTreeModel* model, QItemSelectionModel* selection);
 			void updateSelectionFromLua(OBEngine* eng);
 			void update_toolbar_usability();
 			void populateBasicObjects();
 
 			OBEngine* getCurrentEngine();
 			StudioGLWidget* getCurrentGLWidget(OBEngine* eng);
-			void tickEngines();
+			// True if a game printed or changed anything
+			bool tickEngines();
+			void renderEngines();
+			bool hasActiveWork();
+			void updateTickThreads();
+			void updateFrameStats();
 
 			void sendOutput(QString str);
 			void sendOutput(QString str, QColor col);
 
 			void loadGame(QString toOpen);
+			void updatePlaceProgress();
+
+			void setAutosaveInterval(int secs);
+			void autosaveAll();
+
+			void setUndoMemoryLimit(size_t bytes);
+
+			void setOutputLimit(int lines);
+			void setOutputRateLimit(int perSecond);
+			void setOutputLog(OutputLog* log);
+			void applyOutputFilter();
+			void updateOutputMatches();
+			void setLogToFile(bool enabled, qint64 maxBytes, int maxFiles, bool compress);
+			void updateUndoActions();
+
+			void removeSelection(QString undoText);
+
+			void setCommandTimeSlice(int ms);
+			void updateCommandState();
 
 			void closeEvent(QCloseEvent* evt);
 
@@ -101,14 +169,18 @@ namespace OB{
 			void newInstance();
 			void closeStudio();
 			void commandBarReturn();
+			void stopCommand();
 			void selectionChanged();
 			void insertInstance();
 
 			void tabChanged();
 
 			void explorerContextMenu(const QPoint &pos);
+			void tabContextMenu(const QPoint &pos);
 
 			//Action handlers
+			void undoAct();
+			void redoAct();
 			void cutSelection();
 			void copySelection();
 			void pasteIntoSelection();
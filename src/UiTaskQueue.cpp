@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "UiTaskQueue.h"
+
+namespace OB{
+	namespace Studio{
+		// This is Dmitry Vyukov's intrusive MPSC queue. The stub node
+		// keeps the list non-empty so push never has to touch tail.
+		UiTaskQueue::UiTaskQueue(){
+			stub.next.store(NULL, std::memory_order_relaxed);
+			head.store(&stub, std::memory_order_relaxed);
+			tail = &stub;
+		}
+
+		UiTaskQueue::~UiTaskQueue(){
+			std::function<void()> task;
+			while(pop(task)){}
+		}
+
+		void UiTaskQueue::pushNode(Node* n){
+			n->next.store(NULL, std::memory_order_relaxed);
+			Node* prev = head.exchange(n, std::memory_order_acq_rel);
+			prev->next.store(n, std::memory_order_release);
+		}
+
+		void UiTaskQueue::push(std::function<void()> task){
+			Node* n = new Node();
+			n->task = task;
+			pushNode(n);
+		}
+
+		bool UiTaskQueue::pop(std::function<void()>& task){
+			Node* t = tail;
+			Node* next = t->next.load(std::memory_order_acquire);
+
+			if(t == &stub){
+				if(!next){
+					return false;
+				}
+				tail = next;
+				t = next;
+				next = next->next.load(std::memory_order_acquire);
+			}
+
+			if(next){
+				tail = next;
+				task = std::move(t->task);
+				delete t;
+				return true;
+			}
+
+			// A producer is between the exchange and the link, we'll
+			// see its node on the next pass
+			if(t != head.load(std::memory_order_acquire)){
+				return false;
+			}
+
+			pushNode(&stub);
+
+			next = t->next.load(std::memory_order_acquire);
+			if(next){
+				tail = next;
+				task = std::move(t->task);
+				delete t;
+				return true;
+			}
+
+			return false;
+		}
+
+		int UiTaskQueue::drain(int maxTasks){
+			int ran = 0;
+
+			std::function<void()> task;
+			while((maxTasks < 0 || ran < maxTasks) && pop(task)){
+				if(task){
+					task();
+				}
+				ran++;
+			}
+
+			return ran;
+		}
+
+		bool UiTaskQueue::isEmpty(){
+			return tail == &stub && !stub.next.load(std::memory_order_acquire);
+		}
+	}
+}
@@ -17,26 +17,42 @@
  * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
  */
 
-#ifndef OB_STUDIO_INSTANCETREEITEM_H_
-#define OB_STUDIO_INSTANCETREEITEM_H_
+#ifndef OB_STUDIO_UITASKQUEUE_H_
+#define OB_STUDIO_UITASKQUEUE_H_
 
-#include <instance/Instance.h>
-
-#include <QTreeWidgetItem>
+#include <atomic>
+#include <functional>
 
 namespace OB{
 	namespace Studio{
-		class InstanceTreeItem: public QTreeWidgetItem{
+		/*
+		 * Lock-free multiple producer, single consumer queue of tasks
+		 * to run on the GUI thread. Any thread may push, only the GUI
+		 * thread may pop or drain.
+		 */
+		class UiTaskQueue{
 		public:
-			InstanceTreeItem(shared_ptr<Instance::Instance> inst, QTreeWidget* parent = 0);
-			virtual ~InstanceTreeItem();
+			UiTaskQueue();
+			virtual ~UiTaskQueue();
+
+			void push(std::function<void()> task);
+			bool pop(std::function<void()>& task);
 
-			void updateFlags();
+			int drain(int maxTasks = -1);
 
-			shared_ptr<Instance::Instance> GetInstance();
+			bool isEmpty();
 
 		private:
-			shared_ptr<Instance::Instance> inst;
+			struct Node{
+				std::atomic<Node*> next;
+				std::function<void()> task;
+			};
+
+			void pushNode(Node* n);
+
+			std::atomic<Node*> head;
+			Node* tail;
+			Node stub;
 		};
 	}
 }
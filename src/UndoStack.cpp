@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "UndoStack.h"
+
+#include <OBException.h>
+
+namespace OB{
+	namespace Studio{
+		// UndoCommand
+
+		UndoCommand::UndoCommand(QString text){
+			this->text = text;
+			cost = sizeof(UndoCommand);
+			mergeable = false;
+		}
+
+		/*
+		 * Deleting only unparents instances so undo can put them back.
+		 * Once the command goes away nothing can, so anything it took
+		 * out of the tree that is still out gets destroyed for real.
+		 */
+		UndoCommand::~UndoCommand(){
+			for(auto it = entries.rbegin(); it != entries.rend(); ++it){
+				const Entry& entry = *it;
+				if(entry.kind != Kind::Reparent || (entry.oldParent && entry.newParent)){
+					continue;
+				}
+
+				if(entry.inst->getParent() || entry.inst->ParentLocked){
+					continue;
+				}
+
+				try{
+					entry.inst->Destroy();
+				}catch(OBException* ex){}
+			}
+		}
+
+		QString UndoCommand::getText(){
+			return text;
+		}
+
+		size_t UndoCommand::valueCost(shared_ptr<Instance::Instance> inst, PropertyId prop, shared_ptr<Type::VarWrapper> val){
+			if(!val){
+				return 0;
+			}
+
+			size_t valCost = sizeof(Type::VarWrapper) + 32;
+
+			// Strings are the only values that can get big
+			shared_ptr<const ClassSchema> schema = ClassSchema::forInstance(inst);
+			if(schema){
+				const PropertySchemaEntry* entry = schema->find(prop);
+				if(entry && entry->type == PropertyType::String){
+					valCost += val->asString().size();
+				}
+			}
+
+			return valCost;
+		}
+
+		void UndoCommand::addPropertyChange(shared_ptr<Instance::Instance> inst, PropertyId prop, shared_ptr<Type::VarWrapper> oldVal, shared_ptr<Type::VarWrapper> newVal){
+			if(!inst){
+				return;
+			}
+
+			Entry entry;
+			entry.kind = Kind::Property;
+			entry.inst = inst;
+			entry.prop = prop;
+			entry.oldVal = oldVal;
+			entry.newVal = newVal;
+			entries.push_back(entry);
+
+			cost += sizeof(Entry) + valueCost(inst, prop, oldVal) + valueCost(inst, prop, newVal);
+		}
+
+		void UndoCommand::addReparent(shared_ptr<Instance::Instance> inst, shared_ptr<Instance::Instance> oldParent, shared_ptr<Instance::Instance> newParent){
+			if(!inst || oldParent == newParent){
+				return;
+			}
+
+			Entry entry;
+			entry.kind = Kind::Reparent;
+			entry.inst = inst;
+			entry.prop = 0;
+			entry.oldParent = oldParent;
+			entry.newParent = newParent;
+			entries.push_back(entry);
+
+			cost += sizeof(Entry);
+
+			// Removed instances only live on in the history, so they
+			// count against it along with everything under them
+			if(!newParent){
+				cost += subtreeCost(inst);
+			}
+		}
+
+		size_t UndoCommand::subtreeCost(shared_ptr<Instance::Instance> inst){
+			size_t count = 0;
+
+			std::vector<shared_ptr<Instance::Instance>> pending;
+			pending.push_back(inst);
+			while(!pending.empty()){
+				shared_ptr<Instance::Instance> cur = pending.back();
+				pending.pop_back();
+				count++;
+
+				std::vector<shared_ptr<Instance::Instance>> kids = cur->GetChildren();
+				for(size_t i = 0; i < kids.size(); i++){
+					if(kids[i]){
+						pending.push_back(kids[i]);
+					}
+				}
+			}
+
+			return count * OB_STUDIO_UNDO_INSTANCE_COST;
+		}
+
+		void UndoCommand::setMergeable(bool mergeable){
+			this->mergeable = mergeable;
+		}
+
+		bool UndoCommand::canMergeWith(UndoCommand* next){
+			if(!mergeable || !next || !next->mergeable || text != next->text){
+				return false;
+			}
+
+			if(entries.size() != next->entries.size()){
+				return false;
+			}
+
+			for(size_t i = 0; i < entries.size(); i++){
+				const Entry& a = entries[i];
+				const Entry& b = next->entries[i];
+				if(a.kind != Kind::Property || b.kind != Kind::Property || a.inst != b.inst || a.prop != b.prop){
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		// Keeps our old values and takes next's new ones
+		void UndoCommand::mergeWith(UndoCommand* next){
+			for(size_t i = 0; i < entries.size(); i++){
+				Entry& entry = entries[i];
+
+				cost -= valueCost(entry.inst, entry.prop, entry.newVal);
+				entry.newVal = next->entries[i].newVal;
+				cost += valueCost(entry.inst, entry.prop, entry.newVal);
+			}
+		}
+
+		bool UndoCommand::isEmpty(){
+			return entries.empty();
+		}
+
+		size_t UndoCommand::getCost(){
+			return cost;
+		}
+
+		void UndoCommand::apply(const Entry& entry, bool forward){
+			try{
+				if(entry.kind == Kind::Property){
+					entry.inst->setProperty(PropertyNames::name(entry.prop), forward ? entry.newVal : entry.oldVal);
+				}else{
+					entry.inst->setParent(forward ? entry.newParent : entry.oldParent, true);
+				}
+			}catch(OBException* ex){
+				// Something else changed it since, skip this one
+			}
+		}
+
+		void UndoCommand::undo(){
+			for(auto it = entries.rbegin(); it != entries.rend(); ++it){
+				apply(*it, false);
+			}
+		}
+
+		void UndoCommand::redo(){
+			for(auto it = entries.begin(); it != entries.end(); ++it){
+				apply(*it, true);
+			}
+		}
+
+		// UndoStack
+
+		UndoStack::UndoStack(){
+			memoryLimit = OB_STUDIO_DEFAULT_UNDO_MEMORY_LIMIT;
+			memoryUsage = 0;
+		}
+
+		UndoStack::~UndoStack(){
+			clear();
+		}
+
+		void UndoStack::push(UndoCommand* cmd){
+			if(!cmd){
+				return;
+			}
+
+			if(cmd->isEmpty()){
+				delete cmd;
+				return;
+			}
+
+			for(size_t i = 0; i < redoCmds.size(); i++){
+				memoryUsage -= redoCmds[i]->getCost();
+				delete redoCmds[i];
+			}
+			redoCmds.clear();
+
+			bool recent = lastPush.isValid() && lastPush.elapsed() < OB_STUDIO_UNDO_MERGE_WINDOW;
+			lastPush.start();
+
+			if(recent && !undoCmds.empty() && undoCmds.back()->canMergeWith(cmd)){
+				UndoCommand* top = undoCmds.back();
+
+				memoryUsage -= top->getCost();
+				top->mergeWith(cmd);
+				memoryUsage += top->getCost();
+
+				delete cmd;
+				return;
+			}
+
+			undoCmds.push_back(cmd);
+			memoryUsage += cmd->getCost();
+
+			trim();
+		}
+
+		bool UndoStack::canUndo(){
+			return !undoCmds.empty();
+		}
+
+		bool UndoStack::canRedo(){
+			return !redoCmds.empty();
+		}
+
+		QString UndoStack::getUndoText(){
+			if(undoCmds.empty()){
+				return QString();
+			}
+			return undoCmds.back()->getText();
+		}
+
+		QString UndoStack::getRedoText(){
+			if(redoCmds.empty()){
+				return QString();
+			}
+			return redoCmds.back()->getText();
+		}
+
+		void UndoStack::undo(){
+			if(undoCmds.empty()){
+				return;
+			}
+
+			UndoCommand* cmd = undoCmds.back();
+			undoCmds.pop_back();
+
+			cmd->undo();
+			redoCmds.push_back(cmd);
+
+			// Don't merge the next edit into something already undone
+			lastPush.invalidate();
+		}
+
+		void UndoStack::redo(){
+			if(redoCmds.empty()){
+				return;
+			}
+
+			UndoCommand* cmd = redoCmds.back();
+			redoCmds.pop_back();
+
+			cmd->redo();
+			undoCmds.push_back(cmd);
+
+			lastPush.invalidate();
+		}
+
+		void UndoStack::clear(){
+			for(size_t i = 0; i < undoCmds.size(); i++){
+				delete undoCmds[i];
+			}
+			undoCmds.clear();
+
+			for(size_t i = 0; i < redoCmds.size(); i++){
+				delete redoCmds[i];
+			}
+			redoCmds.clear();
+
+			memoryUsage = 0;
+			lastPush.invalidate();
+		}
+
+		void UndoStack::setMemoryLimit(size_t memoryLimit){
+			this->memoryLimit = memoryLimit;
+			trim();
+		}
+
+		size_t UndoStack::getMemoryLimit(){
+			return memoryLimit;
+		}
+
+		size_t UndoStack::getMemoryUsage(){
+			return memoryUsage;
+		}
+
+		void UndoStack::trim(){
+			while(memoryUsage > memoryLimit && undoCmds.size() > 1){
+				UndoCommand* oldest = undoCmds.front();
+				undoCmds.pop_front();
+
+				memoryUsage -= oldest->getCost();
+				delete oldest;
+			}
+		}
+	}
+}
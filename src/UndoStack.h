@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2017 John M. Harris, Jr. <johnmh@openblox.org>
+ *
+ * This file is part of OpenBlox Studio.
+ *
+ * OpenBlox Studio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenBlox Studio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public License
+ * along with OpenBlox Studio. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OB_STUDIO_UNDOSTACK_H_
+#define OB_STUDIO_UNDOSTACK_H_
+
+#include <QString>
+#include <QElapsedTimer>
+
+#include <instance/Instance.h>
+
+#include "PropertySchema.h"
+
+#include <deque>
+#include <vector>
+
+#define OB_STUDIO_DEFAULT_UNDO_MEMORY_LIMIT (64 * 1024 * 1024)
+#define OB_STUDIO_UNDO_MERGE_WINDOW 1000
+// Rough size of one instance kept alive by the history
+#define OB_STUDIO_UNDO_INSTANCE_COST 2048
+
+namespace OB{
+	namespace Studio{
+		/*
+		 * One user action, stored as what changed rather than a copy
+		 * of the place. Entries are undone in reverse order and redone
+		 * in the order they were added, all in one go.
+		 */
+		class UndoCommand{
+		public:
+			UndoCommand(QString text);
+			virtual ~UndoCommand();
+
+			QString getText();
+
+			void addPropertyChange(shared_ptr<Instance::Instance> inst, PropertyId prop, shared_ptr<Type::VarWrapper> oldVal, shared_ptr<Type::VarWrapper> newVal);
+			void addReparent(shared_ptr<Instance::Instance> inst, shared_ptr<Instance::Instance> oldParent, shared_ptr<Instance::Instance> newParent);
+
+			// Property edits marked mergeable fold into the previous
+			// command if they touch the same properties of the same
+			// instances, so dragging a value is one undo step
+			void setMergeable(bool mergeable);
+			bool canMergeWith(UndoCommand* next);
+			void mergeWith(UndoCommand* next);
+
+			bool isEmpty();
+			size_t getCost();
+
+			void undo();
+			void redo();
+
+		private:
+			enum class Kind{
+				Property,
+				Reparent
+			};
+
+			struct Entry{
+				Kind kind;
+				shared_ptr<Instance::Instance> inst;
+				PropertyId prop;
+				shared_ptr<Type::VarWrapper> oldVal;
+				shared_ptr<Type::VarWrapper> newVal;
+				shared_ptr<Instance::Instance> oldParent;
+				shared_ptr<Instance::Instance> newParent;
+			};
+
+			size_t valueCost(shared_ptr<Instance::Instance> inst, PropertyId prop, shared_ptr<Type::VarWrapper> val);
+			size_t subtreeCost(shared_ptr<Instance::Instance> inst);
+			void apply(const Entry& entry, bool forward);
+
+			QString text;
+			std::vector<Entry> entries;
+			size_t cost;
+			bool mergeable;
+		};
+
+		/*
+		 * Per-tab undo history. Commands are pushed after they've been
+		 * applied. Once the history's estimated size passes the memory
+		 * limit the oldest commands are dropped, the newest one is
+		 * always kept.
+		 */
+		class UndoStack{
+		public:
+			UndoStack();
+			virtual ~UndoStack();
+
+			void push(UndoCommand* cmd);
+
+			bool canUndo();
+			bool canRedo();
+			QString getUndoText();
+			QString getRedoText();
+
+			void undo();
+			void redo();
+			void clear();
+
+			void setMemoryLimit(size_t memoryLimit);
+			size_t getMemoryLimit();
+			size_t getMemoryUsage();
+
+		private:
+			void trim();
+
+			std::deque<UndoCommand*> undoCmds;
+			std::vector<UndoCommand*> redoCmds;
+
+			size_t memoryLimit;
+			size_t memoryUsage;
+
+			QElapsedTimer lastPush;
+		};
+	}
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// End: